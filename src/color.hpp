@@ -1,31 +1,59 @@
 #ifndef COLOR_HPP
 #define COLOR_HPP
 
+#include <cstring>
 #include <string>
+#include <string_view>
 
 // -------------------------------------------------------------------------
 // ANSI Color Codes (for rich CLI output)
 // -------------------------------------------------------------------------
+// Views of string literals: streaming or appending one never allocates.
+// Build styled text with += into a reused buffer rather than with +.
 
-const std::string COLOR_GRAY    = "\033[90m";
-const std::string COLOR_YELLOW  = "\033[93m";
-const std::string COLOR_PURPLE  = "\033[95m";
-const std::string COLOR_CYAN    = "\033[96m";
-const std::string COLOR_GREEN   = "\e[38;5;42m";
-const std::string COLOR_RESET   = "\033[0m";
-const std::string COLOR_RED     = "\033[91m";
-const std::string COLOR_BLUE    = "\033[94m";
-const std::string COLOR_BOLD    = "\033[1m";
-const std::string COLOR_UNDER   = "\033[4m";
-const std::string COLOR_BG_YEL  = "\033[43m";
-const std::string COLOR_BG_CYAN = "\033[46m";
-const std::string COLOR_BG_RED  = "\033[41m";
-const std::string COLOR_BG_GRN  = "\e[48;5;42m";
-const std::string COLOR_BG_MAG  = "\033[45m";
-const std::string COLOR_BG_BLU  = "\033[44m";
-const std::string COLOR_BG_WHT  = "\033[47m";
-const std::string COLOR_BG_BLK  = "\033[40m";
-const std::string COLOR_ORANGE  = "\033[38;5;208m";
-const std::string COLOR_PINK    = "\033[38;5;213m";
+constexpr std::string_view COLOR_GRAY    = "\033[90m";
+constexpr std::string_view COLOR_YELLOW  = "\033[93m";
+constexpr std::string_view COLOR_PURPLE  = "\033[95m";
+constexpr std::string_view COLOR_CYAN    = "\033[96m";
+constexpr std::string_view COLOR_GREEN   = "\e[38;5;42m";
+constexpr std::string_view COLOR_RESET   = "\033[0m";
+constexpr std::string_view COLOR_RED     = "\033[91m";
+constexpr std::string_view COLOR_BLUE    = "\033[94m";
+constexpr std::string_view COLOR_BOLD    = "\033[1m";
+constexpr std::string_view COLOR_UNDER   = "\033[4m";
+constexpr std::string_view COLOR_BG_YEL  = "\033[43m";
+constexpr std::string_view COLOR_BG_CYAN = "\033[46m";
+constexpr std::string_view COLOR_BG_RED  = "\033[41m";
+constexpr std::string_view COLOR_BG_GRN  = "\e[48;5;42m";
+constexpr std::string_view COLOR_BG_MAG  = "\033[45m";
+constexpr std::string_view COLOR_BG_BLU  = "\033[44m";
+constexpr std::string_view COLOR_BG_WHT  = "\033[47m";
+constexpr std::string_view COLOR_BG_BLK  = "\033[40m";
+constexpr std::string_view COLOR_ORANGE  = "\033[38;5;208m";
+constexpr std::string_view COLOR_PINK    = "\033[38;5;213m";
+
+/**
+ * Appends `text` to `out` with its ANSI escape sequences (ESC [ ... final byte)
+ * removed. Used for output that is not going to a terminal. Text without an
+ * ESC byte is appended in one copy.
+ */
+inline void appendWithoutColor(std::string& out, std::string_view text) {
+	const char* p = text.data();
+	const char* end = p + text.size();
+	while (p < end) {
+		const char* esc = static_cast<const char*>(std::memchr(p, '\033', static_cast<size_t>(end - p)));
+		if (!esc) {
+			out.append(p, static_cast<size_t>(end - p));
+			return;
+		}
+		out.append(p, static_cast<size_t>(esc - p));
+		p = esc + 1;
+		if (p < end && *p == '[') {
+			++p;
+			while (p < end && (static_cast<unsigned char>(*p) < 0x40 || static_cast<unsigned char>(*p) > 0x7e)) ++p;
+			if (p < end) ++p;
+		}
+	}
+}
 
 #endif
\ No newline at end of file
@@ -23,13 +23,18 @@ export module common;
 export import <iostream>;
 export import <fstream>;
 export import <string>;
+export import <string_view>;
 export import <map>;
+export import <unordered_map>;
 export import <functional>;
 export import <filesystem>;
 export import <thread>;
 export import <chrono>;
 export import <random>;
 export import <vector>;
+export import <deque>;
+export import <list>;
+export import <memory>;
 export import <regex>;
 export import <cstdio>;
 export import <set>;
@@ -42,3 +47,4 @@ export import <sstream>;
 export import <array>;
 export import <shared_mutex>;
 export import <condition_variable>;
+export import <charconv>;
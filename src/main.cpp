@@ -49,34 +49,777 @@ namespace CLI {
 		{"scan_timeout", "1"},
 		{"user_agent", "Mozilla/5.0"},
 		{"curl_max_time", "2"},
+		{"max_requests", "32"},
+		{"max_rate", "0"},
 		{"payload_dir", "./payloads"},
 		{"default_session_type", "local"},
 		{"default_session_info", ""},
 		{"banner_show", "true"},
-		{"prompt_show", "true"}
+		{"prompt_show", "true"},
+		{"session_dir", ".tcli_sessions"},
+		{"results_file", ".tcli_results"},
+		{"daemon_socket", ".tcli.sock"}
 	};
 
+	/// Built-in values of every option; snapshots store what differs from them.
+	static const std::map<std::string, std::string> configDefaults = config;
+
 	/// Flag to signal CLI shutdown
 	static std::atomic<bool> shouldClose{false};
 
+	// -------------------------------------------------------------------------
+	// Typed Settings
+	// -------------------------------------------------------------------------
+
+	/**
+	 * The options command work reads, parsed and checked once. `config` stays
+	 * the editable front end (`set`, `config set`, the config file, snapshots):
+	 * values enter it through setOption(), and publishSettings() turns the map
+	 * into a new Settings. A command takes the published Settings when it
+	 * starts and its worker threads inherit the pointer, so they read plain
+	 * fields with no lock and no parsing while the map is edited.
+	 *
+	 * Limits that are safe to change mid-run (max_requests, max_rate and the
+	 * timeouts) are read from liveSettings() at each request instead, so
+	 * `set max_requests 2 false` throttles a running crawl right away.
+	 */
+	struct Settings {
+		std::map<std::string, std::string> values;   ///< Every option as published, for snapshots
+		std::string userAgent;
+		std::string curlMaxTime;                     ///< Seconds, as curl --max-time takes them
+		std::string scanTimeout;                     ///< Seconds, as timeout(1) takes them
+		int maxEnumDepth = 0;
+		int maxListDepth = 0;
+		size_t maxRequests = 1;
+		unsigned maxRate = 0;                        ///< Request starts per second; 0 = unlimited
+		std::string localPath;                       ///< lc_path
+		std::string globalPath;                      ///< gl_path
+		std::string sessionDir;
+		std::string resultsFile;
+	};
+
+	/// Why `value` can't be used for `key`, or "" if it can.
+	std::string checkOption(const std::string& key, const std::string& value) {
+		auto whole = [&](long low, long high) -> std::string {
+			if (!value.empty() && value.size() < 10 && std::all_of(value.begin(), value.end(), ::isdigit)
+				&& std::stol(value) >= low && std::stol(value) <= high) return "";
+			return key + " must be a whole number from " + std::to_string(low) + " to " + std::to_string(high);
+		};
+		auto seconds = [&]() -> std::string {
+			bool number = !value.empty() && value.size() < 10 && std::count(value.begin(), value.end(), '.') <= 1
+				&& std::all_of(value.begin(), value.end(), [](char c) { return isdigit(c) || c == '.'; }) && value != ".";
+			if (number && std::stod(value) > 0) return "";
+			return key + " must be a number of seconds above 0";
+		};
+		if (key == "max_enum_depth" || key == "max_list_depth") return whole(0, 64);
+		if (key == "max_requests") return whole(1, 1024);
+		if (key == "max_rate") return whole(0, 100000);
+		if (key == "curl_max_time" || key == "scan_timeout") return seconds();
+		if (key == "user_agent" && value.find_first_of("\"\\$`") != std::string::npos)
+			return "user_agent can't contain quotes, backslashes, $ or `";
+		return "";
+	}
+
+	/// Puts `value` into `config` if it passes checkOption(); returns why not otherwise.
+	std::string setOption(const std::string& key, const std::string& value) {
+		std::string error = checkOption(key, value);
+		if (error.empty()) config[key] = value;
+		return error;
+	}
+
+	/// Builds Settings from option values that checkOption() has already accepted.
+	std::shared_ptr<const Settings> buildSettings(std::map<std::string, std::string> values) {
+		auto s = std::make_shared<Settings>();
+		s->userAgent = values["user_agent"];
+		s->curlMaxTime = values["curl_max_time"];
+		s->scanTimeout = values["scan_timeout"];
+		s->maxEnumDepth = std::stoi(values["max_enum_depth"]);
+		s->maxListDepth = std::stoi(values["max_list_depth"]);
+		s->maxRequests = std::stoul(values["max_requests"]);
+		s->maxRate = static_cast<unsigned>(std::stoul(values["max_rate"]));
+		s->localPath = values["lc_path"];
+		s->globalPath = values["gl_path"];
+		s->sessionDir = values["session_dir"];
+		s->resultsFile = values["results_file"];
+		s->values = std::move(values);
+		return s;
+	}
+
+	/*
+	 * Published Settings are swapped in RCU style: a new version is built off
+	 * to the side and made current with one atomic shared_ptr store, and
+	 * readers take their own reference with an atomic load. Commands and jobs
+	 * hold the version they started with, so a replaced one is freed once the
+	 * last of them lets go, however long the process (or daemon) runs.
+	 */
+	static std::mutex settingsMutex;   ///< Serializes publishers only
+	static std::shared_ptr<const Settings> latestSettings;   ///< Only touched through std::atomic_load/atomic_store
+
+	/// Makes the current `config` the Settings new commands and live limits use.
+	void publishSettings() {
+		std::shared_ptr<const Settings> s = buildSettings(config);
+		std::lock_guard<std::mutex> lock(settingsMutex);
+		std::atomic_store_explicit(&latestSettings, std::move(s), std::memory_order_release);
+	}
+
+	/// The most recently published Settings, kept alive for as long as the caller holds them.
+	inline std::shared_ptr<const Settings> liveSettings() {
+		std::shared_ptr<const Settings> s = std::atomic_load_explicit(&latestSettings, std::memory_order_acquire);
+		if (!s) {
+			publishSettings();
+			s = std::atomic_load_explicit(&latestSettings, std::memory_order_acquire);
+		}
+		return s;
+	}
+
+	/// True for the limits read from liveSettings() at each request rather than from a command's Settings.
+	inline bool isLiveOption(const std::string& key) {
+		return key == "max_requests" || key == "max_rate" || key == "curl_max_time" || key == "scan_timeout";
+	}
+
+	/**
+	 * Settings for one job: the published ones with `overrides` applied where
+	 * checkOption() accepts them. `config` and the published Settings are left
+	 * alone; the job that runs with the result holds the only reference.
+	 */
+	std::shared_ptr<const Settings> deriveSettings(const std::vector<std::pair<std::string, std::string>>& overrides) {
+		std::map<std::string, std::string> values = liveSettings()->values;
+		for (const auto& [key, value] : overrides)
+			if (values.count(key) && checkOption(key, value).empty()) values[key] = value;
+		return buildSettings(std::move(values));
+	}
+
+	/// Settings of the calling thread's command; set when it starts, inherited by its tasks.
+	thread_local std::shared_ptr<const Settings> currentSettings;
+
+	inline const Settings& settings() {
+		if (!currentSettings) currentSettings = liveSettings();
+		return *currentSettings;
+	}
+
 	// -------------------------------------------------------------------------
 	// Session Management Structures
 	// -------------------------------------------------------------------------
 
+	/**
+	 * Cooperative cancellation and pause for one command's work. Worker tasks
+	 * call checkpoint() at every request boundary: it blocks while the work is
+	 * paused and reports false once it has been cancelled, so tasks stop
+	 * scheduling new requests but keep what they already found. Child
+	 * processes doing a request are tracked and terminated on cancel, which
+	 * closes their sockets right away instead of at their timeout.
+	 */
+	class CancellationToken {
+	public:
+		void cancel() {
+			std::lock_guard<std::mutex> lock(mutex);
+			cancelledFlag = true;
+			for (int pid : children) platform::terminateProcess(pid);
+			cv.notify_all();
+		}
+
+		void pause() { pausedFlag = true; }
+
+		void resume() {
+			std::lock_guard<std::mutex> lock(mutex);
+			pausedFlag = false;
+			cv.notify_all();
+		}
+
+		bool cancelled() const { return cancelledFlag; }
+		bool paused() const { return pausedFlag; }
+
+		/// Request boundary: waits while paused; false once cancelled.
+		bool checkpoint() {
+			if (pausedFlag && !cancelledFlag) {
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait(lock, [&] { return !pausedFlag || cancelledFlag; });
+			}
+			return !cancelledFlag;
+		}
+
+		void track(int pid) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (cancelledFlag) platform::terminateProcess(pid);
+			else children.push_back(pid);
+		}
+
+		void untrack(int pid) {
+			std::lock_guard<std::mutex> lock(mutex);
+			children.erase(std::remove(children.begin(), children.end(), pid), children.end());
+		}
+
+	private:
+		std::atomic<bool> cancelledFlag{false};
+		std::atomic<bool> pausedFlag{false};
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::vector<int> children;
+	};
+
+	/**
+	 * What a crawl (enum or ld global) has done and still has to do, kept so
+	 * it can be snapshotted and continued later. A URL is claimed when work
+	 * on it starts and leaves the frontier once it is fully processed (its
+	 * own requests done and its children queued), so after a cancel the
+	 * frontier holds exactly the URLs a resumed crawl has to revisit.
+	 */
+	struct WorkState {
+		enum class Kind : uint32_t { None, Enum, List };
+
+		struct Pending {
+			int depth = 0;
+			std::string target;
+		};
+
+		struct Finding {
+			int status = 0;
+			bool directory = false;
+			std::string target;
+		};
+
+		/// Claims `url` for processing; false if it was claimed before.
+		bool claim(const std::string& url, int depth, const std::string& target) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!visited.insert(url).second) return false;
+			frontier.try_emplace(url, Pending{depth, target});
+			return true;
+		}
+
+		/// Queues `url` for processing; a cancel before it is claimed keeps it pending.
+		void schedule(const std::string& url, int depth, const std::string& target) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!visited.count(url)) frontier.try_emplace(url, Pending{depth, target});
+		}
+
+		/// Marks `url` fully processed.
+		void finish(const std::string& url) {
+			std::lock_guard<std::mutex> lock(mutex);
+			frontier.erase(url);
+		}
+
+		void found(const std::string& url, Finding finding) {
+			std::lock_guard<std::mutex> lock(mutex);
+			findings.insert_or_assign(url, std::move(finding));
+		}
+
+		std::mutex mutex;
+		Kind kind = Kind::None;
+		std::string command;
+		std::set<std::string> visited;
+		std::map<std::string, Pending> frontier;
+		std::map<std::string, Finding> findings;
+	};
+
+	/**
+	 * Control block of a running command. Every command runs as a job so
+	 * Ctrl-C and `session kill` can reach its work through the token. Output
+	 * of background jobs (`cmd &`) is captured here instead of reaching the
+	 * terminal; `session resume` shows what has accumulated since last time.
+	 */
+	struct Job {
+		CancellationToken token;
+		WorkState state;
+		bool captured = true;
+		std::atomic<uint32_t> weight{1};      ///< Share of the request budget relative to other sessions
+		std::string snapshot;                 ///< Snapshot written when the job ended early
+		std::function<void(bool error, std::string_view data)> stream;  ///< Takes captured output as it is written instead of storing it
+		std::atomic<bool> finished{false};
+		std::atomic<bool> failed{false};      ///< Set when the command reported a failure
+		std::mutex outputMutex;               ///< Guards output and shown; never write to std::cout or std::cerr while holding it
+		std::string output;
+		size_t shown = 0;
+	};
+
 	struct Session {
 		int id;
 		std::string type;
 		std::string info;
 		bool active;
+		std::shared_ptr<Job> job;
+		std::string snapshot{};               ///< Saved state on disk from an earlier run
 	};
 	static std::vector<Session> sessions;
 	static int nextSessionId = 1;
 
+	/// The job the calling thread works for; null on the foreground.
+	thread_local std::shared_ptr<Job> currentJob;
+
+	/// The fan-out target (`--targets`) the calling thread works for; null otherwise.
+	thread_local std::shared_ptr<const std::string> currentTarget;
+
+	class RecordQueue;
+
+	/// Pipeline queue the calling thread's command feeds; null when its results go to the terminal.
+	thread_local RecordQueue* currentSink = nullptr;
+
+	/// Joins strings, views and literals into one string with a single allocation.
+	template <class... Parts>
+	std::string concat(const Parts&... parts) {
+		std::string out;
+		out.reserve((std::string_view(parts).size() + ...));
+		(out.append(std::string_view(parts)), ...);
+		return out;
+	}
+
+	/**
+	 * Whether ANSI colors are written to stdout (or stderr with `errors`): only
+	 * when it is a terminal and NO_COLOR is unset. Decided once at startup.
+	 * Daemon clients always get colors and drop them on their side if needed.
+	 */
+	inline bool colorEnabled(bool errors = false) {
+		static const bool noColor = std::getenv("NO_COLOR") && *std::getenv("NO_COLOR");
+		static const bool out = !noColor && platform::isTerminal(false);
+		static const bool err = !noColor && platform::isTerminal(true);
+		if (currentJob && currentJob->stream) return true;
+		return errors ? err : out;
+	}
+
+	/// Prefix tagging output with the calling thread's fan-out target.
+	inline std::string targetTag() {
+		return currentTarget ? concat(COLOR_GRAY, "[", *currentTarget, "] ", COLOR_RESET) : std::string();
+	}
+
+	/// Request boundary for the calling thread's job: waits while paused, false once cancelled.
+	inline bool checkpoint() {
+		return !currentJob || currentJob->token.checkpoint();
+	}
+
+	/// True if the calling thread's job was cancelled (its results so far are partial).
+	inline bool jobCancelled() {
+		return currentJob && currentJob->token.cancelled();
+	}
+
+	/// Crawl state of the calling thread's job; a process-wide one outside jobs.
+	inline WorkState& workState() {
+		static WorkState detached;
+		return currentJob ? currentJob->state : detached;
+	}
+
+	/// Marks `url` done in the job's crawl state, unless a cancel cut its work short.
+	inline void finishUrl(const std::string& url) {
+		if (!jobCancelled()) workState().finish(url);
+	}
+
+	/**
+	 * Budget of concurrent requests shared by every command, job and fan-out
+	 * target, handed out by weighted fair queuing. Each job is a tenant:
+	 * foreground commands always go first and may use a small reserve on
+	 * top of the budget, so they never wait behind background crawls;
+	 * background tenants get slots in proportion to their weight. Within a
+	 * tenant, requests queue per flow (fan-out target, else the job itself)
+	 * and flows take turns, preferring those below an even share, so one
+	 * slow host can't take a session's slots from its other targets.
+	 */
+	class RequestBudget {
+	public:
+		void acquire(const void* tenant, const void* flow, uint32_t weight, bool interactive, size_t limit) {
+			std::unique_lock<std::mutex> lock(mutex);
+			capacity = std::max<size_t>(1, limit);
+			Tenant& t = tenants[tenant];
+			t.weight = std::max<uint32_t>(1, weight);
+			t.interactive = interactive;
+			if (t.turn.empty()) t.virtualTime = std::max(t.virtualTime, clock);
+			Flow& f = t.flows[flow];
+			if (f.waiting++ == 0) t.turn.push_back(flow);
+			grant();
+			cv.wait(lock, [&] { return f.granted > 0; });
+			--f.granted;
+		}
+
+		void release(const void* tenant, const void* flow) {
+			std::lock_guard<std::mutex> lock(mutex);
+			auto t = tenants.find(tenant);
+			auto f = t->second.flows.find(flow);
+			--f->second.held;
+			--t->second.held;
+			--inUse;
+			if (!f->second.held && !f->second.waiting && !f->second.granted) t->second.flows.erase(f);
+			if (t->second.flows.empty()) tenants.erase(t);
+			grant();
+		}
+
+	private:
+		struct Flow {
+			size_t held = 0;
+			size_t waiting = 0;
+			size_t granted = 0;
+		};
+
+		struct Tenant {
+			uint32_t weight = 1;
+			bool interactive = false;
+			double virtualTime = 0;
+			size_t held = 0;
+			std::map<const void*, Flow> flows;
+			std::deque<const void*> turn;
+		};
+
+		size_t limitFor(const Tenant& t) const {
+			return t.interactive ? capacity + std::max<size_t>(1, capacity / 8) : capacity;
+		}
+
+		void grant() {
+			bool granted = false;
+			while (true) {
+				Tenant* next = nullptr;
+				for (auto& [key, t] : tenants) {
+					if (t.turn.empty() || inUse >= limitFor(t)) continue;
+					if (!next || (t.interactive && !next->interactive)
+						|| (t.interactive == next->interactive && t.virtualTime < next->virtualTime))
+						next = &t;
+				}
+				if (!next) break;
+				size_t share = std::max<size_t>(1, capacity / next->flows.size());
+				auto pick = std::find_if(next->turn.begin(), next->turn.end(), [&](const void* o) { return next->flows[o].held < share; });
+				if (pick == next->turn.end()) pick = next->turn.begin();
+				Flow& f = next->flows[*pick];
+				const void* flow = *pick;
+				next->turn.erase(pick);
+				--f.waiting;
+				++f.granted;
+				++f.held;
+				++next->held;
+				++inUse;
+				if (f.waiting) next->turn.push_back(flow);
+				clock = next->virtualTime;
+				next->virtualTime += 1.0 / next->weight;
+				granted = true;
+			}
+			if (granted) cv.notify_all();
+		}
+
+		std::mutex mutex;
+		std::condition_variable cv;
+		std::map<const void*, Tenant> tenants;
+		size_t inUse = 0;
+		size_t capacity = 1;
+		double clock = 0;
+	};
+	static RequestBudget requestBudget;
+
+	/**
+	 * Keeps request starts at least 1/max_rate seconds apart across all work.
+	 * The rate is re-read on every attempt, so changing it takes effect for
+	 * requests already waiting.
+	 */
+	class RequestPacer {
+	public:
+		/// Waits for the calling request's turn; false if its job is cancelled meanwhile.
+		bool wait() {
+			using Clock = std::chrono::steady_clock;
+			while (true) {
+				unsigned rate = liveSettings()->maxRate;
+				if (rate == 0) return true;
+				auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+				Clock::time_point now = Clock::now(), due;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					due = last + interval;
+					if (now >= due) {
+						last = now;
+						return true;
+					}
+				}
+				if (jobCancelled()) return false;
+				std::this_thread::sleep_for(std::min<Clock::duration>(due - now, std::chrono::milliseconds(50)));
+			}
+		}
+
+	private:
+		std::mutex mutex;
+		std::chrono::steady_clock::time_point last;
+	};
+	static RequestPacer requestPacer;
+
+	/// Runs a shell command for the calling thread's job, killable through its token.
+	/// Each command holds one slot of the shared request budget while it runs.
+	std::string runTracked(const std::string& command) {
+		std::shared_ptr<Job> job = currentJob;
+		const void* flow = currentTarget ? static_cast<const void*>(currentTarget.get()) : job.get();
+		// Wait out a pause before taking a slot, so paused jobs never sit on the budget.
+		while (true) {
+			if (!checkpoint()) return "";
+			requestBudget.acquire(job.get(), flow, job ? job->weight.load() : 1, !job || !job->captured, liveSettings()->maxRequests);
+			if (!job || !job->token.paused()) break;
+			requestBudget.release(job.get(), flow);
+		}
+		if (jobCancelled() || !requestPacer.wait()) {
+			requestBudget.release(job.get(), flow);
+			return "";
+		}
+		int child = 0;
+		std::string output = platform::runCommand(command, [&](int pid) {
+			child = pid;
+			if (job) job->token.track(pid);
+		});
+		if (job && child) job->token.untrack(child);
+		requestBudget.release(job.get(), flow);
+		return output;
+	}
+
+	/// Notes that `what` stopped early; whatever it printed or recorded so far stays.
+	void reportCancelled(const char* what) {
+		(currentSink ? std::cerr : std::cout) << COLOR_YELLOW << "[ STOP ]" << COLOR_RESET << " " << what
+				  << " cancelled; results found so far are kept.\n";
+	}
+
+	/// std::async for command worker tasks: the task keeps working for the caller's job.
+	template <class Fn>
+	std::future<void> runTask(Fn&& fn) {
+		return std::async(std::launch::async, [job = currentJob, target = currentTarget, sink = currentSink, s = currentSettings,
+				fn = std::forward<Fn>(fn)]() mutable {
+			currentJob = std::move(job);
+			currentTarget = std::move(target);
+			currentSink = sink;
+			currentSettings = s;
+			fn();
+			currentJob.reset();
+			currentTarget.reset();
+			currentSink = nullptr;
+			currentSettings.reset();
+		});
+	}
+
+	// -------------------------------------------------------------------------
+	// Terminal Writer
+	// -------------------------------------------------------------------------
+
+	/**
+	 * Output of crawler and scanner workers. A worker formats a whole block of
+	 * lines and pushes it onto a lock-free list (one compare-and-swap, never a
+	 * lock or a write), and a single writer thread takes everything queued at
+	 * once and hands it to the terminal in one write, or to the job whose
+	 * thread produced it. Blocks are written whole, so lines never interleave.
+	 * Other terminal output first waits for the queue to drain (see
+	 * JobOutputRouter), which keeps queued lines ahead of whatever a command
+	 * prints once its workers are done.
+	 */
+	class TerminalWriter {
+	public:
+		~TerminalWriter() {
+			if (!writer.joinable()) return;
+			stopping = true;
+			posted.fetch_add(1);
+			posted.notify_one();
+			writer.join();
+		}
+
+		/// Starts the writer thread on `terminal`, the real stdout buffer.
+		void start(std::streambuf* terminal) {
+			out = terminal;
+			color = colorEnabled();
+			writer = std::thread([this] { run(); });
+		}
+
+		/// Queues `text` for the terminal, or for the calling thread's job if it captures output.
+		void push(std::string text) {
+			std::shared_ptr<Job> job = currentJob && currentJob->captured ? currentJob : nullptr;
+			if (!writer.joinable()) {
+				std::cout << text << std::flush;
+				return;
+			}
+			// Counted before it is linked, so a flush never overlooks a block already queued.
+			pushed.fetch_add(1, std::memory_order_acq_rel);
+			Node* node = new Node{std::move(text), std::move(job), head.load(std::memory_order_relaxed)};
+			while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+			posted.fetch_add(1, std::memory_order_release);
+			posted.notify_one();
+		}
+
+		/// Waits until everything pushed so far has been written.
+		void flush() {
+			uint64_t target = pushed.load(std::memory_order_acquire);
+			if (!writer.joinable() || std::this_thread::get_id() == writer.get_id()) return;
+			for (uint64_t done; (done = written.load(std::memory_order_acquire)) < target;) written.wait(done);
+		}
+
+	private:
+		struct Node {
+			std::string text;
+			std::shared_ptr<Job> job;
+			Node* next;
+		};
+
+		std::atomic<Node*> head{nullptr};
+		std::atomic<uint64_t> pushed{0}, written{0};
+		std::atomic<uint32_t> posted{0};   ///< Bumped after each link; the writer sleeps on it
+		std::atomic<bool> stopping{false};
+		std::streambuf* out = nullptr;
+		bool color = true;                 ///< False strips ANSI codes from terminal blocks
+		std::thread writer;
+
+		void run() {
+			std::string batch;
+			std::vector<Node*> nodes;
+			while (true) {
+				uint32_t seen = posted.load(std::memory_order_acquire);
+				Node* list = head.exchange(nullptr, std::memory_order_acquire);
+				if (!list) {
+					if (stopping) return;
+					posted.wait(seen);
+					continue;
+				}
+				for (; list; list = list->next) nodes.push_back(list);
+				// The list is newest first; write in push order.
+				for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+					Node* node = *it;
+					if (!node->job) {
+						if (color) batch += node->text;
+						else appendWithoutColor(batch, node->text);
+					} else if (node->job->stream) {
+						node->job->stream(false, node->text);
+					} else {
+						std::lock_guard<std::mutex> lock(node->job->outputMutex);
+						node->job->output += node->text;
+					}
+				}
+				if (!batch.empty()) {
+					out->sputn(batch.data(), static_cast<std::streamsize>(batch.size()));
+					out->pubsync();
+					batch.clear();
+				}
+				for (Node* node : nodes) delete node;
+				written.fetch_add(nodes.size(), std::memory_order_release);
+				written.notify_all();
+				nodes.clear();
+			}
+		}
+	};
+
+	static TerminalWriter terminalWriter;
+
+	/**
+	 * Stream buffer installed on std::cout and std::cerr that sends writes from
+	 * background job threads to their job's captured output (or its stream,
+	 * for daemon clients) and everything else straight to the terminal, once
+	 * the TerminalWriter's queue has drained. It keeps no buffer of its own,
+	 * so foreground output behaves exactly as before. ANSI codes are dropped on
+	 * the way when the stream is not a terminal or NO_COLOR is set.
+	 */
+	class JobOutputRouter : public std::streambuf {
+	public:
+		JobOutputRouter(std::streambuf* terminal, bool errors) : terminal(terminal), errors(errors) {}
+
+	protected:
+		int_type overflow(int_type ch) override {
+			if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+			char c = traits_type::to_char_type(ch);
+			return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+		}
+
+		std::streamsize xsputn(const char* s, std::streamsize n) override {
+			if (Job* job = currentJob.get(); job && job->captured) {
+				if (job->stream) {
+					job->stream(errors, std::string_view(s, static_cast<size_t>(n)));
+					return n;
+				}
+				std::lock_guard<std::mutex> lock(job->outputMutex);
+				job->output.append(s, static_cast<size_t>(n));
+				return n;
+			}
+			terminalWriter.flush();
+			if (colorEnabled(errors) || !std::memchr(s, '\033', static_cast<size_t>(n))) return terminal->sputn(s, n);
+			thread_local std::string plain;
+			plain.clear();
+			appendWithoutColor(plain, std::string_view(s, static_cast<size_t>(n)));
+			terminal->sputn(plain.data(), static_cast<std::streamsize>(plain.size()));
+			return n;
+		}
+
+		int sync() override { return currentJob && currentJob->captured ? 0 : terminal->pubsync(); }
+
+	private:
+		std::streambuf* terminal;
+		bool errors;
+	};
+
 	// -------------------------------------------------------------------------
 	// Command History
 	// -------------------------------------------------------------------------
 
-	static std::vector<std::string> globalHistory;
+	/**
+	 * Command history shared by the line editor, Ctrl-R search and `history`.
+	 * Entries from earlier runs are views straight into the memory-mapped
+	 * history file; loading only locates line boundaries. Lines typed in this
+	 * session are owned here and appended to the file in batches, one locked
+	 * write per batch, so concurrent instances never interleave partial lines.
+	 * The file is replaced rather than truncated on clear, which keeps other
+	 * instances' mappings valid.
+	 */
+	class CommandHistory {
+	public:
+		~CommandHistory() { flush(); }
+
+		/// Switches to the history stored at `path`; an empty path keeps history in memory only.
+		void open(const std::string& path) {
+			flush();
+			file = path;
+			mapped = path.empty() ? platform::MappedFile() : platform::MappedFile(path);
+			entries.clear();
+			owned.clear();
+			++gen;
+			std::string_view data = mapped.view();
+			// A line without its newline may still be in flight from another instance; skip it.
+			for (size_t pos = 0, end; (end = data.find('\n', pos)) != std::string_view::npos; pos = end + 1) {
+				if (end > pos) entries.push_back(data.substr(pos, end - pos));
+			}
+		}
+
+		/// Records a line; it reaches the file with the next batch.
+		void push(const std::string& line) {
+			owned.push_back(line);
+			entries.push_back(owned.back());
+			if (file.empty()) return;
+			pending += line;
+			pending += '\n';
+			auto now = std::chrono::steady_clock::now();
+			if (++pendingLines >= batchLines || now - lastFlush >= batchDelay) flush();
+		}
+
+		/// Writes pending lines to the history file in one append.
+		void flush() {
+			lastFlush = std::chrono::steady_clock::now();
+			if (pending.empty()) return;
+			if (!platform::appendFile(file, pending))
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Could not write history file: " << file << "\n";
+			pending.clear();
+			pendingLines = 0;
+		}
+
+		/// Drops every entry, here and in the history file.
+		void clear() {
+			pending.clear();
+			pendingLines = 0;
+			entries.clear();
+			owned.clear();
+			++gen;
+			if (!file.empty() && !platform::replaceFile(file, ""))
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Could not clear history file: " << file << "\n";
+			mapped = platform::MappedFile();
+		}
+
+		size_t size() const { return entries.size(); }
+		bool empty() const { return entries.empty(); }
+		std::string_view operator[](size_t i) const { return entries[i]; }
+		/// Bumped whenever existing entries go away, so indexes know to rebuild.
+		uint64_t generation() const { return gen; }
+
+	private:
+		static constexpr size_t batchLines = 16;
+		static constexpr std::chrono::seconds batchDelay{1};
+
+		std::string file;
+		platform::MappedFile mapped;
+		std::vector<std::string_view> entries;
+		std::deque<std::string> owned;
+		std::string pending;
+		size_t pendingLines = 0;
+		std::chrono::steady_clock::time_point lastFlush = std::chrono::steady_clock::now();
+		uint64_t gen = 0;
+	};
+
+	static CommandHistory commandHistory;
 
 	// -------------------------------------------------------------------------
 	// Utility Functions
@@ -110,9 +853,10 @@ namespace CLI {
 	// Configuration File Management
 	// -------------------------------------------------------------------------
 
-	void loadConfig(const std::string& filename) {
+	void loadConfig(const std::string& filename, bool announce = true) {
 		std::ifstream file(filename);
 		if (!file) {
+			if (!announce) return;
 			std::cerr << COLOR_GRAY << "Config file '" << filename << "' not found. Using defaults.\n" << COLOR_RESET;
 
 			std::cout << COLOR_YELLOW << "[ INFO ]" << COLOR_GRAY << " CONFIG - " << COLOR_RESET << "To create a config, run: `tcli setup`\n" << COLOR_RESET;
@@ -124,19 +868,22 @@ namespace CLI {
 			if (pos == std::string::npos) continue;
 			std::string key = line.substr(0, pos);
 			std::string value = line.substr(pos + 1);
-			config[key] = value;
+			if (std::string error = setOption(key, value); !error.empty())
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " " << filename << ": " << error << "; keeping " << config[key] << "\n";
 		}
+		publishSettings();
 	}
 
-	void saveConfig(const std::string& filename) {
+	bool saveConfig(const std::string& filename) {
 		std::ofstream file(filename);
 		if (!file) {
 			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Could not write config file.\n";
-			return;
+			return false;
 		}
 		for (const auto& kv : config) {
 			file << kv.first << "=" << kv.second << "\n";
 		}
+		return true;
 	}
 
 	// -------------------------------------------------------------------------
@@ -145,7 +892,7 @@ namespace CLI {
 
 	void helloBanner() {
 		if (config["banner_show"] == "false") return;
-		std::string banner_color = COLOR_GREEN;
+		std::string_view banner_color = COLOR_GREEN;
 		if (config["banner_color"] == "cyan") banner_color = COLOR_CYAN;
 		else if (config["banner_color"] == "yellow") banner_color = COLOR_YELLOW;
 		else if (config["banner_color"] == "red") banner_color = COLOR_RED;
@@ -179,7 +926,7 @@ namespace CLI {
 
 	inline void printPrompt() {
 		if (config["prompt_show"] == "false") return;
-		std::string prompt_color = COLOR_BG_GRN;
+		std::string_view prompt_color = COLOR_BG_GRN;
 		if (config["prompt_color"] == "cyan") prompt_color = COLOR_BG_CYAN;
 		else if (config["prompt_color"] == "yellow") prompt_color = COLOR_BG_YEL;
 		else if (config["prompt_color"] == "red") prompt_color = COLOR_BG_RED;
@@ -197,864 +944,3423 @@ namespace CLI {
 	}
 
 	// -------------------------------------------------------------------------
-	// Tab Completion Logic
+	// Result Store
 	// -------------------------------------------------------------------------
 
-	// Command and subcommand completion data
-	const std::vector<std::string> mainCommands = {
-		"help", "quit", "exit", "clr", "clear", "rl", "reload", "tcli", "connect", "ld", "enum", "break",
-		"scan", "inject", "auth_bypass", "spoof", "session", "history", "payload_gen", "config", "set"
-	};
-	const std::map<std::string, std::vector<std::string>> subCommands = {
-		{"tcli", {"setup"}},
-		{"connect", {"local", "global"}},
-		{"ld", {"local", "global"}},
-		{"break", {"local", "global"}},
-		{"session", {"list", "kill", "resume"}},
-		{"history", {"clear"}},
-		{"payload_gen", {"reverse_shell", "keylogger"}},
-		{"config", {"show", "set"}},
-		{"spoof", {"mac", "ip", "dns", "user-agent"}},
-		{"inject", {"--sql", "--xss", "--cmd"}},
-		{"set", {}}, // handled dynamically
-	};
-	const std::map<std::string, std::vector<std::string>> connectSubSub = {
-		{"global", {"http", "https"}}
-	};
+	void putU32(std::string& out, uint32_t value) {
+		for (int shift = 0; shift < 32; shift += 8) out += static_cast<char>((value >> shift) & 0xff);
+	}
 
-	// Helper to split input into tokens
-	std::vector<std::string> splitInput(const std::string& input) {
-		std::vector<std::string> tokens;
-		std::istringstream iss(input);
-		std::string token;
-		while (iss >> token) tokens.push_back(token);
-		return tokens;
+	void putString(std::string& out, std::string_view text) {
+		putU32(out, static_cast<uint32_t>(text.size()));
+		out += text;
 	}
 
-	// Print possible completions in a nice format
-	void printCompletions(const std::vector<std::string>& completions) {
-		if (completions.empty()) return;
-		std::cout << "\n";
-		for (size_t i = 0; i < completions.size(); ++i) {
-			std::cout << "  " << COLOR_BOLD << COLOR_PURPLE << completions[i] << COLOR_RESET;
-			if ((i + 1) % 6 == 0) std::cout << "\n";
+	/// One condition of a `query`: `field op value`.
+	struct Predicate {
+		enum class Field : uint8_t { Status, Size, Host, Path, Url, Kind, Source };
+		enum class Op : uint8_t { Eq, Ne, Lt, Le, Gt, Ge, Contains, Prefix };
+		Field field;
+		Op op;
+		std::string text;        ///< Value for text fields (lower-cased for host and `~`)
+		uint64_t number = 0;     ///< Value for numeric fields (status class digit for `2xx`)
+		bool statusClass = false;
+	};
+
+	/**
+	 * Every result `enum`, `ld global` and `scan` produce, kept for `query`.
+	 * Rows are stored column by column: origin (scheme://host, one dictionary
+	 * entry per host), path (in one shared arena), status, size, kind and
+	 * source, so a query touches only the columns it filters on. A URL found
+	 * again by the same source replaces its earlier row, which stays behind
+	 * as a dead entry. Postings per origin and per status, and a path index
+	 * kept as a sorted run plus a tail merged on the next lookup (as in
+	 * CrawlIndex), let a query start from its most selective predicate.
+	 *
+	 * Rows are appended to `results_file` in batches and read back through a
+	 * memory map on first use; each query then reads the rows other instances
+	 * appended since, so a long-lived daemon sees them too:
+	 *   "TCLIRES1" (status source|kind<<8 size-low size-high url)...
+	 */
+	class ResultStore {
+	public:
+		enum Kind : uint8_t { File, Directory, Port };
+		enum Source : uint8_t { Enum, List, Scan };
+		static constexpr uint64_t unknownSize = ~uint64_t(0);
+
+		/// A stored row; the views stay valid only while the store is locked.
+		struct Row {
+			std::string_view origin, path;
+			int status;
+			uint64_t size;
+			Kind kind;
+			Source source;
+		};
+
+		~ResultStore() { flush(); }
+
+		/// Records a result; it reaches the file with the next batch.
+		void add(std::string_view url, int status, uint64_t size, Kind kind, Source source) {
+			std::lock_guard<std::mutex> lock(mutex);
+			open();
+			insert(url, status, size, kind, source);
+			if (file.empty()) return;
+			putU32(pending, static_cast<uint32_t>(status));
+			putU32(pending, source | kind << 8);
+			putU32(pending, static_cast<uint32_t>(size));
+			putU32(pending, static_cast<uint32_t>(size >> 32));
+			putString(pending, url);
+			auto now = std::chrono::steady_clock::now();
+			if (++pendingRows >= batchRows || now - lastFlush >= batchDelay) write();
 		}
-		std::cout << "\n";
-		printPrompt();
-		std::cout.flush();
-	}
 
-	// Find completions for the current buffer
-	std::vector<std::string> getCompletions(const std::string& buffer) {
-		auto tokens = splitInput(buffer);
-		if (tokens.empty()) {
-			return mainCommands;
-		}
-		if (tokens.size() == 1) {
-			std::vector<std::string> matches;
-			for (const auto& cmd : mainCommands) {
-				if (cmd.find(tokens[0]) == 0)
-					matches.push_back(cmd);
-			}
-			return matches;
-		}
-		// Subcommand logic
-		const std::string& cmd = tokens[0];
-		if (subCommands.count(cmd)) {
-			const auto& subs = subCommands.at(cmd);
-			if (tokens.size() == 2) {
-				std::vector<std::string> matches;
-				for (const auto& sub : subs) {
-					if (sub.find(tokens[1]) == 0)
-						matches.push_back(sub);
-				}
-				// Special: connect global <tab>
-				if (cmd == "connect" && tokens[1] == "global" && tokens.size() == 2) {
-					return {"http", "https"};
-				}
-				return matches;
-			}
-			// connect global <tab>
-			if (cmd == "connect" && tokens.size() == 3 && tokens[1] == "global") {
-				std::vector<std::string> matches;
-				for (const auto& proto : connectSubSub.at("global")) {
-					if (proto.find(tokens[2]) == 0)
-						matches.push_back(proto);
+		/// Writes pending rows to the results file in one append.
+		void flush() {
+			std::lock_guard<std::mutex> lock(mutex);
+			write();
+		}
+
+		/**
+		 * Calls `visit` for every live row matching all of `where`, in the order
+		 * rows were stored, until it returns false. `scanned` receives how many
+		 * rows were examined, so callers can tell whether an index helped.
+		 */
+		size_t select(const std::vector<Predicate>& where, const std::function<bool(const Row&)>& visit, size_t& scanned) {
+			std::lock_guard<std::mutex> lock(mutex);
+			open();
+			if (!file.empty()) readTail();
+			std::vector<uint32_t> candidates;
+			bool indexed = false;
+			for (const Predicate& p : where) {
+				std::vector<uint32_t> rows;
+				if (!lookup(p, rows)) continue;
+				if (!indexed || rows.size() < candidates.size()) candidates = std::move(rows);
+				indexed = true;
+			}
+			size_t total = indexed ? candidates.size() : statuses.size();
+			size_t matched = 0;
+			scanned = 0;
+			for (size_t i = 0; i < total; ++i) {
+				uint32_t r = indexed ? candidates[i] : static_cast<uint32_t>(i);
+				if (!live[r]) continue;
+				++scanned;
+				if (!std::all_of(where.begin(), where.end(), [&](const Predicate& p) { return matches(p, r); })) continue;
+				++matched;
+				if (!visit(row(r))) break;
+			}
+			return matched;
+		}
+
+	private:
+		static constexpr size_t batchRows = 256;
+		static constexpr std::chrono::seconds batchDelay{1};
+		static constexpr std::string_view magic = "TCLIRES1";
+
+		struct Origin {
+			std::string text;    ///< scheme://host[:port], lower-cased
+			std::string host;    ///< Host name alone
+			std::vector<uint32_t> rows;
+		};
+
+		/// Row holding each (source, url), keyed by their hash. Open addressing in
+		/// two flat arrays: a node-based map costs an allocation per stored row.
+		class LatestRows {
+		public:
+			static constexpr uint32_t none = ~uint32_t(0);
+
+			/// Makes `row` the one for `key`; returns the row it replaces, or none.
+			uint32_t replace(uint64_t key, uint32_t row) {
+				if ((used + 1) * 2 > keys.size()) grow();
+				key += key == 0;
+				size_t mask = keys.size() - 1;
+				for (size_t i = key & mask;; i = (i + 1) & mask) {
+					if (keys[i] == 0) {
+						keys[i] = key;
+						rows[i] = row;
+						++used;
+						return none;
+					}
+					if (keys[i] == key) {
+						uint32_t earlier = rows[i];
+						rows[i] = row;
+						return earlier;
+					}
 				}
-				return matches;
-			}
-		}
-		// For inject, suggest modes if 3rd token
-		if (cmd == "inject" && tokens.size() == 3) {
-			std::vector<std::string> modes = {"--sql", "--xss", "--cmd"};
-			std::vector<std::string> matches;
-			for (const auto& m : modes) {
-				if (m.find(tokens[2]) == 0)
-					matches.push_back(m);
-			}
-			return matches;
-		}
-		// For spoof, suggest types
-		if (cmd == "spoof" && tokens.size() == 2) {
-			std::vector<std::string> types = {"mac", "ip", "dns", "user-agent"};
-			std::vector<std::string> matches;
-			for (const auto& t : types) {
-				if (t.find(tokens[1]) == 0)
-					matches.push_back(t);
-			}
-			return matches;
-		}
-		// For payload_gen
-		if (cmd == "payload_gen" && tokens.size() == 2) {
-			std::vector<std::string> types = {"reverse_shell", "keylogger"};
-			std::vector<std::string> matches;
-			for (const auto& t : types) {
-				if (t.find(tokens[1]) == 0)
-					matches.push_back(t);
-			}
-			return matches;
-		}
-		// For config
-		if (cmd == "config" && tokens.size() == 2) {
-			std::vector<std::string> types = {"show", "set"};
-			std::vector<std::string> matches;
-			for (const auto& t : types) {
-				if (t.find(tokens[1]) == 0)
-					matches.push_back(t);
-			}
-			return matches;
-		}
-		// For session
-		if (cmd == "session" && tokens.size() == 2) {
-			std::vector<std::string> types = {"list", "kill", "resume"};
-			std::vector<std::string> matches;
-			for (const auto& t : types) {
-				if (t.find(tokens[1]) == 0)
-					matches.push_back(t);
-			}
-			return matches;
-		}
-		// For break
-		if (cmd == "break" && tokens.size() == 2) {
-			std::vector<std::string> types = {"local", "global"};
-			std::vector<std::string> matches;
-			for (const auto& t : types) {
-				if (t.find(tokens[1]) == 0)
-					matches.push_back(t);
-			}
-			return matches;
-		}
-		// For ld
-		if (cmd == "ld" && tokens.size() == 2) {
-			std::vector<std::string> types = {"local", "global"};
-			std::vector<std::string> matches;
-			for (const auto& t : types) {
-				if (t.find(tokens[1]) == 0)
-					matches.push_back(t);
-			}
-			return matches;
-		}
-		// For history
-		if (cmd == "history" && tokens.size() == 2) {
-			std::vector<std::string> types = {"clear"};
-			std::vector<std::string> matches;
-			for (const auto& t : types) {
-				if (t.find(tokens[1]) == 0)
-					matches.push_back(t);
-			}
-			return matches;
-		}
-		return {};
-	}
+			}
 
-	// -------------------------------------------------------------------------
-	// Command Implementations
-	// -------------------------------------------------------------------------
+			/// Makes room for `count` keys without rehashing.
+			void reserve(size_t count) {
+				size_t slots = 1024;
+				while (slots < count * 2) slots *= 2;
+				while (keys.size() < slots) grow();
+			}
 
-	inline void cmdQuit(const std::string&) { shouldClose = true; }
-	inline void cmdClear(const std::string&) { clearScreen(); }
+		private:
+			std::vector<uint64_t> keys;
+			std::vector<uint32_t> rows;
+			size_t used = 0;
 
-	void cmdReload(const std::string&) {
-		clearScreen();
-		helloBanner();
-		loadingBar("Reloading TCLI config");
-		loadConfig("TCLI");
-		std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Reload complete.\n";
-	}
+			void grow() {
+				std::vector<uint64_t> oldKeys(std::max<size_t>(1024, keys.size() * 2));
+				std::vector<uint32_t> oldRows(oldKeys.size());
+				oldKeys.swap(keys);
+				oldRows.swap(rows);
+				used = 0;
+				for (size_t i = 0; i < oldKeys.size(); ++i)
+					if (oldKeys[i]) replace(oldKeys[i], oldRows[i]);
+			}
+		};
 
-	void cmdSetup(const std::string&) {
-		std::cout << COLOR_YELLOW << "Do you want to create a new TCLI config file? (y/n): " << COLOR_RESET;
-		std::string answer;
-		std::getline(std::cin, answer);
-		std::transform(answer.begin(), answer.end(), answer.begin(), ::tolower);
-		if (answer == "y" || answer == "yes") {
-			saveConfig("TCLI");
-			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Config file 'TCLI' created.\n";
-		} else {
-			std::cout << COLOR_GRAY << "Config file not created.\n" << COLOR_RESET;
+		/// A block this instance appended, skipped when the file is read back.
+		struct Written {
+			uint64_t offset;
+			size_t size;
+		};
+
+		std::mutex mutex;
+		bool loaded = false;
+		std::string opened;            ///< results_file the rows come from
+		std::string file;              ///< Where rows are saved; empty if they are not
+		std::string pending;
+		size_t pendingRows = 0;
+		uint64_t readTo = 0;           ///< File bytes read so far, up to the last whole row
+		std::deque<Written> written;
+		std::chrono::steady_clock::time_point lastFlush = std::chrono::steady_clock::now();
+
+		std::deque<Origin> origins;
+		std::unordered_map<std::string_view, uint32_t> originIds;   ///< Keys view Origin::text
+		uint32_t lastOrigin = 0;
+		std::string pathArena;
+		std::vector<uint32_t> originOf;
+		std::vector<uint64_t> pathOffset;
+		std::vector<uint32_t> pathLength;
+		std::vector<uint16_t> statuses;
+		std::vector<uint64_t> sizes;
+		std::vector<Kind> kinds;
+		std::vector<Source> sources;
+		std::vector<bool> live;
+		LatestRows latest;
+		std::map<uint16_t, std::vector<uint32_t>> byStatus;
+		std::vector<uint32_t> byPath;
+		size_t pathSorted = 0;
+		mutable std::string scratch;   ///< Reused to join origin and path for url conditions
+
+		std::string_view pathOf(uint32_t r) const { return std::string_view(pathArena).substr(pathOffset[r], pathLength[r]); }
+		Row row(uint32_t r) const { return {origins[originOf[r]].text, pathOf(r), statuses[r], sizes[r], kinds[r], sources[r]}; }
+
+		/// Opens `results_file` on first use, and again whenever the setting changes.
+		void open() {
+			std::shared_ptr<const Settings> live = liveSettings();
+			const std::string& wanted = live->resultsFile;
+			if (loaded && wanted == opened) return;
+			write();
+			reset();
+			loaded = true;
+			opened = file = wanted;
+			if (!file.empty()) readTail();
 		}
-	}
 
-	void cmdConnect(const std::string& args) {
-		if (startsWith(args, "local ")) {
-			std::string path = args.substr(6);
-			if (fs::exists(path) && fs::is_directory(path)) {
-				config["lc_path"] = path;
-				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Connected to local path: " << path << "\n";
-			} else {
-				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Local path does not exist or is not a directory: " << path << "\n";
+		/// Reads the rows appended to the results file since the last read, other than this instance's own.
+		void readTail() {
+			platform::MappedFile mapped(file);
+			std::string_view data = mapped.view();
+			if (readTo == 0) {
+				if (data.empty()) {
+					// Started under the append lock, so instances opening the same new file write one header between them.
+					if (!platform::startFile(file, magic)) {
+						std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Could not write results file, results will not be saved: " << file << "\n";
+						file.clear();
+					}
+					return;
+				}
+				if (data.substr(0, magic.size()) != magic) {
+					std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Not a results file, results will not be saved: " << file << "\n";
+					file.clear();
+					return;
+				}
+				readTo = magic.size();
 			}
-		} else if (startsWith(args, "global ")) {
-			std::string url = args.substr(7);
-			std::smatch m;
-			static const std::regex proto_domain(R"(^\s*(https?|HTTPS?)\s+([^\s]+))");
-			if (std::regex_match(url, m, proto_domain)) {
-				std::string proto = m[1].str();
-				std::string domain = m[2].str();
-				std::string fullUrl = proto + "://" + domain;
-				config["gl_path"] = fullUrl;
-				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Connected to global URL: " << fullUrl << "\n";
-			} else if (startsWith(url, "http://") || startsWith(url, "https://")) {
-				config["gl_path"] = url;
-				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Connected to global URL: " << url << "\n";
-			} else {
-				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: connect global <http(s) example.com> or connect global <http(s)://url>\n";
+			if (data.size() <= readTo) return;
+			std::string_view rest = data.substr(readTo);
+			auto u32 = [](std::string_view at) {
+				uint32_t value = 0;
+				for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<unsigned char>(at[i])) << (8 * i);
+				return value;
+			};
+			// A row cut short may still be in flight from another instance; stop before it.
+			auto complete = [&](std::string_view tail) { return tail.size() >= 20 && tail.size() - 20 >= u32(tail.substr(16)); };
+			if (statuses.empty()) {
+				// Size every column once up front instead of growing them row by row.
+				size_t rows = 0, bytes = 0;
+				for (std::string_view tail = rest; complete(tail); ++rows) {
+					bytes += u32(tail.substr(16));
+					tail.remove_prefix(20 + u32(tail.substr(16)));
+				}
+				reserve(rows, bytes);
 			}
-		} else {
-			std::cerr << COLOR_GRAY
-					<< "Usage:\n"
-					<< "  connect local <valid-local-path>\n"
-					<< "  connect global <http(s) example.com>\n"
-					<< "  connect global <http(s)://url>\n"
-					<< COLOR_RESET;
+			while (complete(rest)) {
+				uint64_t at = data.size() - rest.size();
+				while (!written.empty() && written.front().offset < at) written.pop_front();
+				if (!written.empty() && written.front().offset == at && rest.size() >= written.front().size) {
+					rest.remove_prefix(written.front().size);
+					written.pop_front();
+					continue;
+				}
+				uint32_t flags = u32(rest.substr(4));
+				uint64_t size = u32(rest.substr(8)) | static_cast<uint64_t>(u32(rest.substr(12))) << 32;
+				insert(rest.substr(20, u32(rest.substr(16))), static_cast<int>(u32(rest)), size,
+					static_cast<Kind>(flags >> 8 & 0xff), static_cast<Source>(flags & 0xff));
+				rest.remove_prefix(20 + u32(rest.substr(16)));
+			}
+			readTo = data.size() - rest.size();
 		}
-	}
 
-	void listLocalDirectories() {
-		std::string localPath = config["lc_path"];
-		if (!fs::exists(localPath) || !fs::is_directory(localPath)) {
-			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Local path does not exist or is not a directory: " << localPath << "\n";
-			return;
+		/// Forgets every row, before the store moves to another file.
+		void reset() {
+			pending.clear();
+			pendingRows = 0;
+			readTo = 0;
+			written.clear();
+			origins.clear();
+			originIds.clear();
+			lastOrigin = 0;
+			pathArena.clear();
+			originOf.clear();
+			pathOffset.clear();
+			pathLength.clear();
+			statuses.clear();
+			sizes.clear();
+			kinds.clear();
+			sources.clear();
+			live.clear();
+			latest = LatestRows();
+			byStatus.clear();
+			byPath.clear();
+			pathSorted = 0;
 		}
-		std::vector<std::string> dirs, files;
-		std::vector<std::future<void>> futures;
-		std::mutex mtx;
-		for (auto& entry : fs::directory_iterator(localPath)) {
-			futures.push_back(std::async(std::launch::async, [&entry, &dirs, &files, &mtx] {
-				if (entry.is_directory()) {
-					std::lock_guard<std::mutex> lock(mtx);
-					dirs.push_back(entry.path().filename().string());
-				} else {
-					std::lock_guard<std::mutex> lock(mtx);
-					files.push_back(entry.path().filename().string());
+
+		void reserve(size_t rows, size_t bytes) {
+			pathArena.reserve(bytes);
+			originOf.reserve(rows);
+			pathOffset.reserve(rows);
+			pathLength.reserve(rows);
+			statuses.reserve(rows);
+			sizes.reserve(rows);
+			kinds.reserve(rows);
+			sources.reserve(rows);
+			live.reserve(rows);
+			byPath.reserve(rows);
+			latest.reserve(rows);
+		}
+
+		void write() {
+			lastFlush = std::chrono::steady_clock::now();
+			if (pendingRows == 0) return;
+			uint64_t offset = 0;
+			if (platform::appendFile(file, pending, &offset)) written.push_back({offset, pending.size()});
+			else std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Could not write results file: " << file << "\n";
+			pending.clear();
+			pendingRows = 0;
+		}
+
+		void insert(std::string_view url, int status, uint64_t size, Kind kind, Source source) {
+			size_t scheme = url.find("://");
+			size_t hostEnd = scheme == std::string_view::npos ? 0 : std::min(url.find('/', scheme + 3), url.size());
+			std::string_view origin = url.substr(0, hostEnd);
+			std::string lowered;
+			if (std::any_of(origin.begin(), origin.end(), [](char c) { return c >= 'A' && c <= 'Z'; })) {
+				lowered = origin;
+				std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+				origin = lowered;
+			}
+			// Results arrive grouped by host, so the previous row's origin usually matches.
+			if (origins.empty() || origins[lastOrigin].text != origin) {
+				auto it = originIds.find(origin);
+				if (it == originIds.end()) {
+					std::string host(scheme == std::string_view::npos ? std::string_view() : origin.substr(scheme + 3));
+					if (size_t colon = host.rfind(':'); colon != std::string::npos && host.find(']', colon) == std::string::npos)
+						host.erase(colon);
+					origins.push_back({std::string(origin), std::move(host), {}});
+					it = originIds.emplace(origins.back().text, static_cast<uint32_t>(origins.size() - 1)).first;
 				}
-			}));
+				lastOrigin = it->second;
+			}
+			uint32_t r = static_cast<uint32_t>(statuses.size());
+			uint64_t key = std::hash<std::string_view>()(url.substr(hostEnd)) ^ (lastOrigin * 2 + 1ull) * 0x9e3779b97f4a7c15ull ^ source;
+			if (uint32_t earlier = latest.replace(key, r); earlier != LatestRows::none) live[earlier] = false;
+			origins[lastOrigin].rows.push_back(r);
+			originOf.push_back(lastOrigin);
+			pathOffset.push_back(pathArena.size());
+			pathLength.push_back(static_cast<uint32_t>(url.size() - hostEnd));
+			pathArena += url.substr(hostEnd);
+			statuses.push_back(static_cast<uint16_t>(status));
+			sizes.push_back(size);
+			kinds.push_back(kind);
+			sources.push_back(source);
+			live.push_back(true);
+			byStatus[static_cast<uint16_t>(status)].push_back(r);
+			byPath.push_back(r);
 		}
-		for (auto& f : futures) f.wait();
-		std::cout << COLOR_GREEN << "Directories in local path (" << localPath << "):" << COLOR_RESET << "\n";
-		for (const auto& d : dirs)
-			std::cout << "  - " << COLOR_BLUE << d << COLOR_RESET << "\n";
-		for (const auto& f : files)
-			std::cout << "  - " << COLOR_GRAY << f << COLOR_RESET << "\n";
+
+		/// Fills `rows` (ascending) from an index that answers `p`; false if none does.
+		bool lookup(const Predicate& p, std::vector<uint32_t>& rows) {
+			using F = Predicate::Field;
+			using O = Predicate::Op;
+			if (p.field == F::Status && p.op == O::Eq) {
+				auto first = byStatus.lower_bound(static_cast<uint16_t>(p.statusClass ? p.number * 100 : p.number));
+				auto last = byStatus.upper_bound(static_cast<uint16_t>(p.statusClass ? p.number * 100 + 99 : p.number));
+				for (auto it = first; it != last; ++it) rows.insert(rows.end(), it->second.begin(), it->second.end());
+			} else if (p.field == F::Host && (p.op == O::Eq || p.op == O::Contains)) {
+				for (const Origin& o : origins)
+					if (p.op == O::Eq ? o.host == p.text : o.host.find(p.text) != std::string::npos)
+						rows.insert(rows.end(), o.rows.begin(), o.rows.end());
+			} else if (p.field == F::Path && p.op == O::Prefix) {
+				mergePaths();
+				auto first = std::lower_bound(byPath.begin(), byPath.end(), std::string_view(p.text),
+					[&](uint32_t r, std::string_view v) { return pathOf(r) < v; });
+				for (auto it = first; it != byPath.end() && pathOf(*it).substr(0, p.text.size()) == p.text; ++it) rows.push_back(*it);
+			} else {
+				return false;
+			}
+			std::sort(rows.begin(), rows.end());
+			return true;
+		}
+
+		/// Sorts new rows into the path index. They are first ordered by their
+		/// first 16 path bytes held in two integers, which keeps the sort out of
+		/// the arena; only rows sharing those bytes compare whole paths.
+		void mergePaths() {
+			if (pathSorted == byPath.size()) return;
+			struct Key {
+				uint64_t high, low;
+				uint32_t row;
+			};
+			std::vector<Key> keys;
+			keys.reserve(byPath.size() - pathSorted);
+			for (size_t i = pathSorted; i < byPath.size(); ++i) {
+				std::string_view path = pathOf(byPath[i]);
+				Key key{0, 0, byPath[i]};
+				for (size_t b = 0; b < 16; ++b) {
+					uint64_t byte = b < path.size() ? static_cast<unsigned char>(path[b]) : 0;
+					(b < 8 ? key.high : key.low) |= byte << (8 * (7 - b % 8));
+				}
+				keys.push_back(key);
+			}
+			std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) { return a.high != b.high ? a.high < b.high : a.low < b.low; });
+			auto byText = [&](uint32_t a, uint32_t b) { return pathOf(a) < pathOf(b); };
+			for (size_t i = 0, j; i < keys.size(); i = j) {
+				for (j = i + 1; j < keys.size() && keys[j].high == keys[i].high && keys[j].low == keys[i].low; ++j) {}
+				if (j - i > 1) std::sort(keys.begin() + i, keys.begin() + j, [&](const Key& a, const Key& b) { return byText(a.row, b.row); });
+			}
+			for (size_t i = 0; i < keys.size(); ++i) byPath[pathSorted + i] = keys[i].row;
+			std::inplace_merge(byPath.begin(), byPath.begin() + static_cast<std::ptrdiff_t>(pathSorted), byPath.end(), byText);
+			pathSorted = byPath.size();
+		}
+
+		bool matches(const Predicate& p, uint32_t r) const {
+			using F = Predicate::Field;
+			using O = Predicate::Op;
+			auto compare = [&](auto value, auto wanted) {
+				switch (p.op) {
+					case O::Eq: return value == wanted;
+					case O::Ne: return value != wanted;
+					case O::Lt: return value < wanted;
+					case O::Le: return value <= wanted;
+					case O::Gt: return value > wanted;
+					case O::Ge: return value >= wanted;
+					default: return false;
+				}
+			};
+			auto text = [&](std::string_view value) {
+				switch (p.op) {
+					case O::Eq: return value == p.text;
+					case O::Ne: return value != p.text;
+					case O::Prefix: return value.substr(0, p.text.size()) == p.text;
+					case O::Contains:
+						return std::search(value.begin(), value.end(), p.text.begin(), p.text.end(),
+							[](char a, char b) { return (a >= 'A' && a <= 'Z' ? a + ('a' - 'A') : a) == b; }) != value.end();
+					default: return false;
+				}
+			};
+			switch (p.field) {
+				case F::Status: return compare(p.statusClass ? statuses[r] / 100u : statuses[r], p.number);
+				case F::Size: return sizes[r] != unknownSize && compare(sizes[r], p.number);
+				case F::Host: return text(origins[originOf[r]].host);
+				case F::Path: return text(pathOf(r));
+				case F::Url:
+					scratch.assign(origins[originOf[r]].text).append(pathOf(r));
+					return text(scratch);
+				case F::Kind: return compare(static_cast<uint64_t>(kinds[r]), p.number);
+				case F::Source: return compare(static_cast<uint64_t>(sources[r]), p.number);
+			}
+			return false;
+		}
+	};
+
+	static ResultStore resultStore;
+
+	// -------------------------------------------------------------------------
+	// Pipelines
+	// -------------------------------------------------------------------------
+
+	/// One result passed between pipeline stages instead of formatted text.
+	struct Record {
+		std::string url;                             ///< URL, or path for local listings
+		int status = 0;                              ///< HTTP status; 0 when not probed
+		bool directory = false;
+		std::shared_ptr<const std::string> target;   ///< Fan-out target it belongs to, if any
+		uint64_t size = ResultStore::unknownSize;    ///< Body length, when the response was fetched
+	};
+
+	/// Fixed-capacity queue between two stages: push blocks while full, pop while empty.
+	class RecordQueue {
+	public:
+		explicit RecordQueue(size_t capacity = 256) : capacity(capacity) {}
+
+		void push(Record record) {
+			std::unique_lock<std::mutex> lock(mutex);
+			notFull.wait(lock, [&] { return items.size() < capacity; });
+			items.push_back(std::move(record));
+			notEmpty.notify_one();
+		}
+
+		/// Takes the next record if one is waiting; never blocks.
+		bool tryPop(Record& out) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (items.empty()) return false;
+			out = std::move(items.front());
+			items.pop_front();
+			notFull.notify_one();
+			return true;
+		}
+
+		/// Takes the next record; false once the queue is closed and drained.
+		bool pop(Record& out) {
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [&] { return !items.empty() || closed; });
+			if (items.empty()) return false;
+			out = std::move(items.front());
+			items.pop_front();
+			notFull.notify_one();
+			return true;
+		}
+
+		/// Marks the end of the stream; the producer calls it once it is done.
+		void close() {
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+			notEmpty.notify_all();
+		}
+
+	private:
+		std::mutex mutex;
+		std::condition_variable notFull, notEmpty;
+		std::deque<Record> items;
+		size_t capacity;
+		bool closed = false;
+	};
+
+	/// True if the calling thread's results feed a pipeline rather than the terminal.
+	inline bool piped() { return currentSink != nullptr; }
+
+	/**
+	 * Reports a result: crawls keep it in their state for snapshots and in
+	 * the result store for `query`, and it goes down the pipeline when piped.
+	 * `size` is the body length when the response was fetched.
+	 * False when not piped, so the caller prints it.
+	 */
+	inline bool emitRecord(std::string url, int status, bool directory, uint64_t size = ResultStore::unknownSize) {
+		if (WorkState& state = workState(); state.kind != WorkState::Kind::None) {
+			state.found(url, {status, directory, currentTarget ? *currentTarget : std::string()});
+			resultStore.add(url, status, size, directory ? ResultStore::Directory : ResultStore::File,
+				state.kind == WorkState::Kind::Enum ? ResultStore::Enum : ResultStore::List);
+		}
+		if (!currentSink) return false;
+		currentSink->push({std::move(url), status, directory, currentTarget, size});
+		return true;
 	}
 
-	std::string combineUrl(const std::string& base, const std::string& relative) {
-		if (relative.empty()) return base;
-		if (startsWith(relative, "http://") || startsWith(relative, "https://")) return relative;
-		std::string b = base;
-		if (!b.empty() && b.back() == '/') b.pop_back();
-		if (!relative.empty() && relative[0] == '/') {
-			std::regex domain_regex(R"(^https?://[^/]+)");
-			std::smatch match;
-			if (std::regex_search(b, match, domain_regex)) return match.str(0) + relative;
-			return b + relative;
+	/// Appends `text` to `out` as a JSON string literal.
+	void appendJsonString(std::string& out, std::string_view text) {
+		static constexpr char hex[] = "0123456789abcdef";
+		out += '"';
+		size_t plain = 0;
+		for (size_t i = 0; i < text.size(); ++i) {
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			if (c >= 0x20 && c != '"' && c != '\\') continue;
+			out.append(text.data() + plain, i - plain);
+			plain = i + 1;
+			out += '\\';
+			switch (c) {
+				case '"': out += '"'; break;
+				case '\\': out += '\\'; break;
+				case '\n': out += 'n'; break;
+				case '\r': out += 'r'; break;
+				case '\t': out += 't'; break;
+				default:
+					out += "u00";
+					out += hex[c >> 4];
+					out += hex[c & 15];
+			}
 		}
-		return b + "/" + relative;
+		out.append(text.data() + plain, text.size() - plain);
+		out += '"';
 	}
 
-	std::vector<std::string> extractLinks(const std::string& html) {
-		std::vector<std::string> links;
-		static const std::regex href_regex(R"###(<a\s+(?:[^>]*?\s+)?href="([^"]*)")###", std::regex::icase);
-		auto begin = std::sregex_iterator(html.begin(), html.end(), href_regex);
-		auto end = std::sregex_iterator();
-		links.reserve(std::distance(begin, end));
-		for (auto i = begin; i != end; ++i)
-			links.push_back((*i)[1].str());
-		return links;
+	/// Appends `value` to `out` in decimal.
+	void appendNumber(std::string& out, uint64_t value) {
+		char digits[20];
+		out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
 	}
 
-	std::string httpGet(const std::string& url, const std::string& cookies = "", const std::string& userAgent = "") {
-		std::string ua = userAgent.empty() ? config["user_agent"] : userAgent;
-		std::string cmd = "curl -s --max-time " + config["curl_max_time"] + " -A \"" + ua + "\"";
-		if (!cookies.empty()) cmd += " -b \"" + cookies + "\"";
-		cmd += " \"" + url + "\"";
-		std::string result;
-		FILE* pipe = popen(cmd.c_str(), "r");
-		if (!pipe) return "";
-		char buffer[4096];
-		while (fgets(buffer, sizeof(buffer), pipe) != nullptr)
-			result += buffer;
-		pclose(pipe);
-		return result;
+	/// Appends a byte count formatted as 512, 1.5K, 20M ...
+	void appendSize(std::string& out, uint64_t bytes) {
+		static const char units[] = "KMGT";
+		if (bytes < 1024) return appendNumber(out, bytes);
+		double value = static_cast<double>(bytes);
+		int unit = -1;
+		while (value >= 1024 && unit < 3) {
+			value /= 1024;
+			++unit;
+		}
+		char text[16];
+		out.append(text, static_cast<size_t>(std::snprintf(text, sizeof(text), value < 10 ? "%.1f%c" : "%.0f%c", value, units[unit])));
 	}
 
-	void enumerateDirectories(const std::string& baseUrl, int depth = 0, int maxDepth = -1, std::set<std::string>* visited = nullptr) {
-		if (maxDepth == -1) maxDepth = std::stoi(config["max_enum_depth"]);
-		static const std::vector<std::string> commonDirs = {
-			"admin/", "private/", "secret/", "hidden/", "config/", "backup/", "data/", "uploads/", "files/", "tmp/", "test/", "dev/", "logs/", "bin/", "cgi-bin/",
-			".git/", ".svn/", ".env/", ".htaccess", ".htpasswd", "db/", "db_backup/", "old/", "new/", "staging/", "beta/", "alpha/", "api/", "assets/", "images/", "css/", "js/"
-		};
-		static std::shared_mutex visMutex;
-		static std::set<std::string> staticVisited;
-		if (!visited) visited = &staticVisited;
-		{
-			std::unique_lock lock(visMutex);
-			if (depth > maxDepth || visited->count(baseUrl)) return;
-			visited->insert(baseUrl);
+	/**
+	 * Appends one result as a text line, `[target] status size url`, to `out`;
+	 * an empty target, zero status or unknown size is left out. Colors are only
+	 * written when stdout shows them, so plain lines are little more than a copy.
+	 */
+	void appendRecordLine(std::string& out, std::string_view url, int status, bool directory,
+		std::string_view target, uint64_t size = ResultStore::unknownSize) {
+		const bool color = colorEnabled();
+		auto paint = [&](std::string_view code) { if (color) out += code; };
+		if (!target.empty()) {
+			paint(COLOR_GRAY);
+			out += '[';
+			out += target;
+			out += "] ";
+			paint(COLOR_RESET);
 		}
-		std::string indent(depth * 2, ' ');
-		std::cout << indent << COLOR_GREEN << "Enumerating: " << baseUrl << COLOR_RESET << "\n";
-		std::string html = httpGet(baseUrl);
-		if (html.empty()) {
-			std::cout << indent << COLOR_YELLOW << "(No response or empty)" << COLOR_RESET << "\n";
-			return;
+		if (status) {
+			paint(status < 400 ? COLOR_GREEN : COLOR_YELLOW);
+			appendNumber(out, static_cast<uint64_t>(status));
+			paint(COLOR_RESET);
+			out += ' ';
+		}
+		if (size != ResultStore::unknownSize) {
+			paint(COLOR_GRAY);
+			appendSize(out, size);
+			paint(COLOR_RESET);
+			out += ' ';
 		}
+		if (directory) paint(COLOR_PURPLE);
+		out += url;
+		if (directory) paint(COLOR_RESET);
+		out += '\n';
+	}
 
-		static std::map<std::string, std::string> notFoundCache;
-		std::string notFoundSig;
-		{
-			std::unique_lock lock(visMutex);
-			if (notFoundCache.count(baseUrl)) {
-				notFoundSig = notFoundCache[baseUrl];
-			} else {
-				std::string fake404 = httpGet(combineUrl(baseUrl, "__tcli_fake404__" + std::to_string(rand()) + "/"));
-				notFoundSig = fake404.substr(0, 512);
-				notFoundCache[baseUrl] = notFoundSig;
-			}
+	/**
+	 * Appends one record as a JSON line for `--output jsonl`:
+	 *   {"url":"...","status":200,"directory":true,"size":512,"target":"..."}
+	 * `status`, `size` and `target` are left out when unknown. Builds into the
+	 * caller's buffer, so a reused buffer makes it allocation-free.
+	 */
+	void appendJsonRecord(std::string& out, const Record& r) {
+		out += "{\"url\":";
+		appendJsonString(out, r.url);
+		if (r.status) {
+			out += ",\"status\":";
+			appendNumber(out, static_cast<uint64_t>(r.status));
+		}
+		out += r.directory ? ",\"directory\":true" : ",\"directory\":false";
+		if (r.size != ResultStore::unknownSize) {
+			out += ",\"size\":";
+			appendNumber(out, r.size);
 		}
+		if (r.target) {
+			out += ",\"target\":";
+			appendJsonString(out, *r.target);
+		}
+		out += "}\n";
+	}
 
-		std::vector<std::string> links = extractLinks(html);
-		std::set<std::string> foundDirs;
-		for (const auto& link : links)
-			if (link != "../" && link != "./" && !link.empty() && link.back() == '/')
-				foundDirs.insert(link);
+	/**
+	 * Removes `--output <format>` from a command line; `json` is set for
+	 * `jsonl`. False, after reporting it, for an unknown format.
+	 */
+	bool takeOutputOption(std::string& command, bool& json) {
+		size_t at = command.find(" --output");
+		if (at == std::string::npos || (at + 9 < command.size() && command[at + 9] != ' ')) return true;
+		size_t start = command.find_first_not_of(' ', at + 9);
+		size_t end = start == std::string::npos ? command.size() : std::min(command.find(' ', start), command.size());
+		std::string format = start == std::string::npos ? "" : command.substr(start, end - start);
+		if (format != "jsonl" && format != "text") {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Unknown output format: '" << format << "' (use jsonl or text)\n";
+			return false;
+		}
+		json = format == "jsonl";
+		command.erase(at, end - at);
+		return true;
+	}
 
-		std::vector<std::future<void>> futures;
-		std::mutex foundMutex;
-		for (const auto& dir : commonDirs) {
-			if (foundDirs.count(dir)) continue;
-			futures.push_back(std::async(std::launch::async, [&, dir, indent, notFoundSig] {
-				std::string tryUrl = combineUrl(baseUrl, dir);
-				std::string probe = httpGet(tryUrl);
-				if (probe.empty()) return;
+	/// Splits a command line at `|` words outside quotes: the command, then each stage.
+	std::vector<std::string> splitPipeline(const std::string& line) {
+		std::vector<std::string> parts(1);
+		char quote = 0;
+		for (size_t i = 0; i < line.size(); ++i) {
+			char c = line[i];
+			if (quote) {
+				if (c == quote) quote = 0;
+			} else if (c == '"' || c == '\'') {
+				quote = c;
+			} else if (c == '|' && (i == 0 || line[i - 1] == ' ') && (i + 1 == line.size() || line[i + 1] == ' ')) {
+				parts.emplace_back();
+				continue;
+			}
+			parts.back() += c;
+		}
+		for (std::string& part : parts) {
+			part.erase(0, part.find_first_not_of(' '));
+			part.erase(part.find_last_not_of(' ') + 1);
+		}
+		return parts;
+	}
 
-				bool not404 = probe.substr(0, 512) != notFoundSig;
-				bool statusOk = false;
-				{
-					std::string cmd = "curl -s -o /dev/null -w \"%{http_code}\" \"" + tryUrl + "\"";
-					FILE* pipe = popen(cmd.c_str(), "r");
-					if (pipe) {
-						char buf[16] = {0};
-						fgets(buf, sizeof(buf), pipe);
-						std::string code(buf);
-						pclose(pipe);
-						statusOk = (code.find("200") != std::string::npos || code.find("301") != std::string::npos || code.find("302") != std::string::npos);
-					}
+	/**
+	 * Runs `producer` with its results streaming through `stages`:
+	 *   match <regex>      keeps records whose URL or path matches
+	 *   status <code>...   keeps records with one of the statuses (`2xx` for a class)
+	 *   count              prints how many records arrived (last stage only)
+	 * Every stage runs on its own thread between bounded queues, so filtering
+	 * overlaps with the producer's requests and only what comes out of the
+	 * last stage is ever formatted: as text, or with `json` as JSON lines
+	 * gathered in one buffer that is written whenever the queue runs dry.
+	 * False if a stage is invalid, in which case nothing runs.
+	 */
+	bool runPipeline(const std::function<void()>& producer, const std::vector<std::string>& stages, bool json = false) {
+		std::vector<std::function<bool(const Record&)>> filters;
+		bool counting = false;
+		for (size_t i = 0; i < stages.size(); ++i) {
+			std::istringstream iss(stages[i]);
+			std::string name, arg;
+			iss >> name;
+			std::getline(iss >> std::ws, arg);
+			if (name == "match" && !arg.empty()) {
+				if (arg.size() >= 2 && (arg.front() == '"' || arg.front() == '\'') && arg.back() == arg.front())
+					arg = arg.substr(1, arg.size() - 2);
+				try {
+					filters.push_back([re = std::regex(arg)](const Record& r) { return std::regex_search(r.url, re); });
+				} catch (const std::regex_error&) {
+					std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Invalid pattern for match: " << arg << "\n";
+					return false;
 				}
-				bool looksLikeDir = false;
-				static const std::vector<std::string> dirPatterns = {
-					"Index of", "Parent Directory", "<title>Index of", "Directory listing for", "To Parent Directory"
-				};
-				for (const auto& pat : dirPatterns) {
-					if (probe.find(pat) != std::string::npos) {
-						looksLikeDir = true;
-						break;
+			} else if (name == "status" && !arg.empty()) {
+				std::vector<int> codes, classes;
+				std::istringstream list(arg);
+				for (std::string code; list >> code;) {
+					if (code.size() == 3 && code.compare(1, 2, "xx") == 0 && isdigit(code[0])) classes.push_back(code[0] - '0');
+					else if (!code.empty() && std::all_of(code.begin(), code.end(), ::isdigit)) codes.push_back(std::stoi(code));
+					else {
+						std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Invalid status code: " << code << "\n";
+						return false;
 					}
 				}
-				std::smatch m;
-				std::string title;
-				if (std::regex_search(probe, m, std::regex("<title>(.*?)</title>", std::regex::icase)))
-					title = m[1].str();
-				bool titleOk = !title.empty() && title.find("404") == std::string::npos && title.find("Not Found") == std::string::npos;
-				bool notRedirect = true;
-				if (probe.find("http-equiv=\"refresh\"") != std::string::npos && probe.find(baseUrl) != std::string::npos)
-					notRedirect = false;
-				int score = 0;
-				if (not404) score++;
-				if (statusOk) score++;
-				if (looksLikeDir) score++;
-				if (titleOk) score++;
-				if (notRedirect) score++;
-				if (score >= 2) {
-					std::lock_guard<std::mutex> lock(foundMutex);
-					foundDirs.insert(dir);
-					std::cout << indent << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " " << dir
-						<< "  " << COLOR_GRAY << "("
-						<< (not404 ? "not404 " : "")
-						<< (statusOk ? "statusOK " : "")
-						<< (looksLikeDir ? "dirPattern " : "")
-						<< (titleOk ? "titleOK " : "")
-						<< (notRedirect ? "notRedirect" : "")
-						<< ")" << COLOR_RESET << "\n";
-				}
-			}));
+				filters.push_back([codes, classes](const Record& r) {
+					return std::find(codes.begin(), codes.end(), r.status) != codes.end()
+						|| std::find(classes.begin(), classes.end(), r.status / 100) != classes.end();
+				});
+			} else if (name == "count" && arg.empty() && i + 1 == stages.size()) {
+				counting = true;
+			} else {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Unknown pipeline stage: " << stages[i] << "\n"
+						  << COLOR_GRAY << "Stages: match <regex>, status <code>..., count (last)" << COLOR_RESET << "\n";
+				return false;
+			}
 		}
-		for (auto& f : futures) f.wait();
 
-		std::vector<std::future<void>> recFutures;
-		for (const auto& dir : foundDirs) {
-			std::string fullUrl = combineUrl(baseUrl, dir);
-			std::cout << indent << COLOR_PURPLE << "[" << dir << "]" << COLOR_RESET << "\n";
-			recFutures.push_back(std::async(std::launch::async, [&, fullUrl, depth, maxDepth, visited] {
-				enumerateDirectories(fullUrl, depth + 1, maxDepth, visited);
+		std::vector<std::unique_ptr<RecordQueue>> queues;
+		for (size_t i = 0; i <= filters.size(); ++i) queues.push_back(std::make_unique<RecordQueue>());
+		std::vector<std::future<void>> tasks;
+		tasks.push_back(runTask([&] {
+			currentSink = queues.front().get();
+			producer();
+			currentSink = nullptr;
+			queues.front()->close();
+		}));
+		for (size_t i = 0; i < filters.size(); ++i) {
+			tasks.push_back(runTask([&, i] {
+				for (Record r; queues[i]->pop(r);)
+					if (filters[i](r)) queues[i + 1]->push(std::move(r));
+				queues[i + 1]->close();
 			}));
 		}
-		for (auto& f : recFutures) f.wait();
+		size_t count = 0;
+		std::string out;
+		auto write = [&] {
+			if (out.empty()) return;
+			std::cout.write(out.data(), static_cast<std::streamsize>(out.size())).flush();
+			out.clear();
+		};
+		for (Record r; queues.back()->tryPop(r) || (write(), queues.back()->pop(r)); ++count) {
+			if (counting) continue;
+			if (json) appendJsonRecord(out, r);
+			else appendRecordLine(out, r.url, r.status, r.directory, r.target ? std::string_view(*r.target) : std::string_view());
+			if (out.size() >= 64 * 1024) write();
+		}
+		for (auto& t : tasks) t.wait();
+		if (counting) std::cout << (json ? "{\"count\":" : "") << count << (json ? "}\n" : "\n");
+		return true;
 	}
 
-	void listGlobalRecursive(const std::string& url, int depth = 0, int maxDepth = -1) {
-		if (maxDepth == -1) maxDepth = std::stoi(config["max_list_depth"]);
-		if (depth > maxDepth) return;
-		std::string indent(depth * 2, ' ');
-		std::cout << indent << COLOR_GREEN << "Listing: " << url << COLOR_RESET << "\n";
-		std::string html = httpGet(url);
-		if (html.empty()) {
-			std::cout << indent << COLOR_YELLOW << "(Failed to fetch or empty content)" << COLOR_RESET << "\n";
-			return;
+	// -------------------------------------------------------------------------
+	// Session Snapshots
+	// -------------------------------------------------------------------------
+
+	/*
+	 * A snapshot is a crawl's WorkState in a compact binary file under
+	 * `session_dir`, named after the session id. Integers are 32-bit little
+	 * endian, strings are length-prefixed, and each list starts with a count:
+	 *   "TCLISNAP" version kind command
+	 *   (key value)...                    config values that differ from the defaults
+	 *   url...                            visited URLs, frontier excluded
+	 *   (url depth target)...             frontier
+	 *   (url status directory target)...  findings
+	 */
+	constexpr std::string_view snapshotMagic = "TCLISNAP";
+	constexpr uint32_t snapshotVersion = 1;
+
+	std::string snapshotPath(int id) {
+		return (fs::path(settings().sessionDir) / (std::to_string(id) + ".snap")).string();
+	}
+
+	/// Writes `state` to `path`, replacing any earlier snapshot atomically.
+	bool saveSnapshot(WorkState& state, const std::string& path) {
+		std::string out(snapshotMagic);
+		putU32(out, snapshotVersion);
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			putU32(out, static_cast<uint32_t>(state.kind));
+			putString(out, state.command);
+			std::vector<std::pair<std::string_view, std::string_view>> overrides;
+			for (const auto& [key, value] : settings().values) {
+				auto def = configDefaults.find(key);
+				if (def == configDefaults.end() || def->second != value) overrides.emplace_back(key, value);
+			}
+			putU32(out, static_cast<uint32_t>(overrides.size()));
+			for (const auto& [key, value] : overrides) {
+				putString(out, key);
+				putString(out, value);
+			}
+			std::vector<std::string_view> done;
+			for (const std::string& url : state.visited)
+				if (!state.frontier.count(url)) done.push_back(url);
+			putU32(out, static_cast<uint32_t>(done.size()));
+			for (std::string_view url : done) putString(out, url);
+			putU32(out, static_cast<uint32_t>(state.frontier.size()));
+			for (const auto& [url, pending] : state.frontier) {
+				putString(out, url);
+				putU32(out, static_cast<uint32_t>(pending.depth));
+				putString(out, pending.target);
+			}
+			putU32(out, static_cast<uint32_t>(state.findings.size()));
+			for (const auto& [url, finding] : state.findings) {
+				putString(out, url);
+				putU32(out, static_cast<uint32_t>(finding.status));
+				putU32(out, finding.directory ? 1 : 0);
+				putString(out, finding.target);
+			}
 		}
-		std::vector<std::string> links = extractLinks(html);
-		if (links.empty()) {
-			std::cout << indent << COLOR_YELLOW << "(No links found)" << COLOR_RESET << "\n";
-			return;
+		std::error_code ec;
+		fs::create_directories(fs::path(path).parent_path(), ec);
+		return platform::replaceFile(path, out);
+	}
+
+	/// Reads snapshot fields in order; reading past the end clears `ok`.
+	class SnapshotReader {
+	public:
+		explicit SnapshotReader(std::string_view data) : data(data) {}
+
+		bool header() {
+			if (data.substr(0, snapshotMagic.size()) != snapshotMagic) return ok = false;
+			data.remove_prefix(snapshotMagic.size());
+			return u32() == snapshotVersion && ok;
 		}
-		std::vector<std::string> directories, files;
-		for (const auto& link : links) {
-			if (link == "../" || link == "./" || link.empty()) continue;
-			if (!link.empty() && link.back() == '/') directories.push_back(link);
-			else files.push_back(link);
+
+		uint32_t u32() {
+			if (data.size() < 4) {
+				ok = false;
+				return 0;
+			}
+			uint32_t value = 0;
+			for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+			data.remove_prefix(4);
+			return value;
 		}
-		if (files.empty() && directories.empty()) {
-			std::cout << indent << COLOR_YELLOW << "(No files or directories found)" << COLOR_RESET << "\n";
-			return;
+
+		std::string_view str() {
+			uint32_t size = u32();
+			if (!ok || data.size() < size) {
+				ok = false;
+				return {};
+			}
+			std::string_view text = data.substr(0, size);
+			data.remove_prefix(size);
+			return text;
 		}
-		for (const auto& file : files) {
-			std::string ext = file.substr(file.find_last_of('.') + 1);
-			std::string color = COLOR_GRAY;
-			if (ext == "cpp" || ext == "h" || ext == "hpp" || ext == "c") color = COLOR_BLUE;
-			else if (ext == "sh" || ext == "py" || ext == "pl" || ext == "rb") color = COLOR_GREEN;
-			else if (ext == "txt" || ext == "md") color = COLOR_YELLOW;
-			else if (ext == "zip" || ext == "tar" || ext == "gz" || ext == "rar") color = COLOR_RED;
-			else if (ext == "json" || ext == "xml") color = COLOR_CYAN;
-			else if (ext == "jpg" || ext == "png" || ext == "gif") color = COLOR_PINK;
-			std::cout << indent << "  " << color << file << COLOR_RESET << "\n";
+
+		bool ok = true;
+
+	private:
+		std::string_view data;
+	};
+
+	/// The command a snapshot continues, or "" if `path` is not a readable snapshot.
+	std::string snapshotCommand(const std::string& path) {
+		platform::MappedFile file(path);
+		SnapshotReader in(file.view());
+		if (!in.header()) return "";
+		in.u32();
+		std::string command(in.str());
+		return in.ok ? command : "";
+	}
+
+	/**
+	 * Maps the snapshot at `path` and rebuilds its WorkState into `state`;
+	 * saved config values go to `overrides`. False if the file is missing or damaged.
+	 */
+	bool loadSnapshot(const std::string& path, WorkState& state, std::vector<std::pair<std::string, std::string>>& overrides) {
+		platform::MappedFile file(path);
+		SnapshotReader in(file.view());
+		if (!in.header()) return false;
+		uint32_t kind = in.u32();
+		if (kind != static_cast<uint32_t>(WorkState::Kind::Enum) && kind != static_cast<uint32_t>(WorkState::Kind::List)) return false;
+		std::lock_guard<std::mutex> lock(state.mutex);
+		state.kind = static_cast<WorkState::Kind>(kind);
+		state.command = in.str();
+		for (uint32_t n = in.u32(); in.ok && n; --n) {
+			std::string_view key = in.str();
+			overrides.emplace_back(key, in.str());
 		}
-		std::vector<std::future<void>> futures;
-		for (const auto& dir : directories) {
-			std::string fullUrl = combineUrl(url, dir);
-			std::cout << indent << COLOR_PURPLE << "[" << dir << "]" << COLOR_RESET << "\n";
-			futures.push_back(std::async(std::launch::async, [&, fullUrl, depth, maxDepth] {
-				listGlobalRecursive(fullUrl, depth + 1, maxDepth);
-			}));
+		for (uint32_t n = in.u32(); in.ok && n; --n)
+			state.visited.emplace_hint(state.visited.end(), in.str());
+		for (uint32_t n = in.u32(); in.ok && n; --n) {
+			std::string url(in.str());
+			int depth = static_cast<int>(in.u32());
+			state.frontier.emplace(std::move(url), WorkState::Pending{depth, std::string(in.str())});
 		}
-		for (auto& f : futures) f.wait();
+		for (uint32_t n = in.u32(); in.ok && n; --n) {
+			std::string url(in.str());
+			WorkState::Finding finding;
+			finding.status = static_cast<int>(in.u32());
+			finding.directory = in.u32() != 0;
+			finding.target = in.str();
+			state.findings.emplace(std::move(url), std::move(finding));
+		}
+		return in.ok;
 	}
 
-	inline void cmdListLocal(const std::string&) { listLocalDirectories(); }
-	void cmdListGlobal(const std::string&) {
-		if (config["gl_path"] == "n/a") {
-			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No global URL connected. Use 'connect global <url>' first.\n";
-			return;
+	/**
+	 * Settles a background job's snapshot when it ends: a crawl cut short
+	 * (killed, or stopped on exit) is saved for `session resume`, and one
+	 * that ran to completion removes any snapshot it was resumed from.
+	 */
+	void settleJob(Job& job, int id) {
+		if (job.state.kind == WorkState::Kind::None) return;
+		std::string path = snapshotPath(id);
+		bool pending;
+		{
+			std::lock_guard<std::mutex> lock(job.state.mutex);
+			pending = !job.state.frontier.empty();
+		}
+		if (job.token.cancelled() && pending) {
+			if (saveSnapshot(job.state, path)) job.snapshot = path;
+		} else {
+			std::error_code ec;
+			fs::remove(path, ec);
 		}
-		listGlobalRecursive(config["gl_path"]);
 	}
 
-	void cmdHelp(const std::string&) {
-		std::cout << COLOR_BOLD << COLOR_CYAN << "TCLI Help\n" << COLOR_RESET;
-		std::cout << COLOR_BOLD << "Available commands:\n" << COLOR_RESET;
-		std::cout << COLOR_PURPLE << "  help" << COLOR_RESET << "         Show this help message\n";
-		std::cout << COLOR_PURPLE << "  quit, exit" << COLOR_RESET << "   Exit the CLI\n";
-		std::cout << COLOR_PURPLE << "  clr, clear" << COLOR_RESET << "   Clear the screen\n";
-		std::cout << COLOR_PURPLE << "  rl, reload" << COLOR_RESET << "   Reload config and banner\n";
-		std::cout << COLOR_PURPLE << "  tcli setup" << COLOR_RESET << "   Create a new config file\n";
-		std::cout << COLOR_PURPLE << "  connect local <path>" << COLOR_RESET << "   Connect to a local directory\n";
-		std::cout << COLOR_PURPLE << "  connect global <url>" << COLOR_RESET << "   Connect to a global URL\n";
-		std::cout << COLOR_PURPLE << "  ld local" << COLOR_RESET << "     List local directories/files\n";
-		std::cout << COLOR_PURPLE << "  ld global" << COLOR_RESET << "    List global directories/files recursively\n";
-		std::cout << COLOR_PURPLE << "  enum" << COLOR_RESET << "         Enumerate directories on global URL\n";
-		std::cout << COLOR_PURPLE << "  break local|global" << COLOR_RESET << "   Break link and clear history for local/global\n";
-		std::cout << COLOR_PURPLE << "  scan [target]" << COLOR_RESET << "   Scan local/remote for open ports/services\n";
-		std::cout << COLOR_PURPLE << "  inject [target] [payload] [--sql|--xss|--cmd]" << COLOR_RESET << "   Simulate injection attacks\n";
-		std::cout << COLOR_PURPLE << "  auth_bypass [target]" << COLOR_RESET << "   Test for insecure authentication\n";
-		std::cout << COLOR_PURPLE << "  spoof [type] [options]" << COLOR_RESET << "   Spoof mac/ip/dns/user-agent\n";
-		std::cout << COLOR_PURPLE << "  session list" << COLOR_RESET << "   List active sessions\n";
-		std::cout << COLOR_PURPLE << "  session kill <id>" << COLOR_RESET << "   Terminate session by ID\n";
-		std::cout << COLOR_PURPLE << "  session resume <id>" << COLOR_RESET << "   Resume a saved session\n";
-		std::cout << COLOR_PURPLE << "  history" << COLOR_RESET << "   Show command history\n";
-		std::cout << COLOR_PURPLE << "  history clear" << COLOR_RESET << "   Clear entire history\n";
-		std::cout << COLOR_PURPLE << "  payload_gen <type>" << COLOR_RESET << "   Generate a custom payload (reverse_shell, keylogger)\n";
-		std::cout << COLOR_PURPLE << "  config show" << COLOR_RESET << "   Display current configuration\n";
-		std::cout << COLOR_PURPLE << "  config set <key> <value>" << COLOR_RESET << "   Change a config option\n";
-		std::cout << COLOR_PURPLE << "  set <key> <value> <true|false>" << COLOR_RESET << "   Set config in realtime (true=persist)\n";
-		std::cout << COLOR_BOLD << "Syntax Highlighting:\n" << COLOR_RESET;
-		std::cout << "  " << COLOR_BOLD << "Commands" << COLOR_RESET << ": " << COLOR_PURPLE << "purple bold" << COLOR_RESET << "\n";
-		std::cout << "  " << COLOR_BOLD << "Paths" << COLOR_RESET << ": " << COLOR_YELLOW << "yellow bold" << COLOR_RESET << "\n";
-		std::cout << "  " << COLOR_BOLD << "URLs" << COLOR_RESET << ": " << COLOR_CYAN << "cyan underline" << COLOR_RESET << "\n";
-		std::cout << "  " << COLOR_BOLD << "Numbers" << COLOR_RESET << ": " << COLOR_GREEN << "green" << COLOR_RESET << "\n";
-		std::cout << "  " << COLOR_BOLD << "Strings" << COLOR_RESET << ": " << COLOR_BG_BLU << COLOR_YELLOW << "yellow on blue" << COLOR_RESET << "\n";
-		std::cout << "  " << COLOR_BOLD << "Options/flags" << COLOR_RESET << ": " << COLOR_BG_YEL << COLOR_BLUE << "blue on yellow" << COLOR_RESET << "\n";
-		std::cout << "  " << COLOR_BOLD << "Local/Global" << COLOR_RESET << ": " << COLOR_BG_GRN << COLOR_GRAY << " LOCAL " << COLOR_RESET << " / " << COLOR_BG_CYAN << COLOR_GRAY << " GLOBAL " << COLOR_RESET << "\n";
-		std::cout << COLOR_BOLD << "Tips:\n" << COLOR_RESET;
-		std::cout << "  Use " << COLOR_BOLD << "Tab" << COLOR_RESET << " for auto-completion (now available!)\n";
-		std::cout << "  Use " << COLOR_BOLD << "Up/Down" << COLOR_RESET << " arrows for history navigation\n";
+	/**
+	 * Runs `work` as background job `id` on a thread of its own. `finished` is
+	 * set last, once the work and everything it held are gone, so stopJobs()
+	 * can wait on it before the process tears down what jobs use.
+	 */
+	void launchJob(std::shared_ptr<Job> job, int id, std::function<void()> work, std::shared_ptr<const Settings> jobSettings = nullptr) {
+		std::thread([job, id, work = std::move(work), s = jobSettings ? std::move(jobSettings) : liveSettings()]() mutable {
+			platform::lowerThreadPriority();
+			currentJob = job;
+			currentSettings = s;
+			work();
+			work = nullptr;
+			currentJob.reset();
+			terminalWriter.flush();
+			settleJob(*job, id);   // Saves the job's own settings, so they are let go only afterwards
+			currentSettings.reset();
+			s.reset();
+			job->finished = true;
+		}).detach();
 	}
 
-	void cmdEnum(const std::string&) {
-		if (config["gl_path"] == "n/a") {
-			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No global URL connected. Use 'connect global <url>' first.\n";
-			return;
+	// -------------------------------------------------------------------------
+	// Command Registry
+	// -------------------------------------------------------------------------
+
+	/// Runs a command; returns false if it failed (it has said why on stderr).
+	using CommandHandler = bool (*)(const std::string& args);
+
+	/// A subcommand with its own handler, dispatched on the first argument.
+	struct Subcommand {
+		std::string_view name;
+		CommandHandler handler;
+	};
+
+	/// One line of `help` output.
+	struct CommandHelp {
+		std::string_view usage;
+		std::string_view text;
+	};
+
+	/**
+	 * Everything the CLI knows about one command. `grammar` holds the Tab
+	 * completion rules for what may follow the name: `a|b` lists alternatives
+	 * and `<name>` is an argument slot filled by the completion source of that
+	 * name. Arity counts whitespace-separated arguments; maxArgs -1 is unbounded.
+	 */
+	struct CommandSpec {
+		std::string_view name;
+		std::vector<std::string_view> aliases;
+		CommandHandler handler = nullptr;     ///< Runs when no subcommand matches; nullptr prints usage
+		std::vector<Subcommand> subcommands;
+		int minArgs = 0;
+		int maxArgs = -1;
+		std::string_view usage;
+		std::vector<std::string_view> grammar;
+		std::vector<CommandHelp> help;
+		bool background = false;              ///< May run as a job with a trailing `&`
+		bool records = false;                 ///< Emits records, so it can feed a `|` pipeline
+	};
+
+	/**
+	 * The single table of commands. Dispatch, Tab completion, syntax
+	 * highlighting and `help` all read from it, so adding a command is one
+	 * entry in `commandRegistry()`. Names and aliases resolve through one hash
+	 * lookup; the expanded completion grammar is built once with the table.
+	 */
+	class CommandRegistry {
+	public:
+		explicit CommandRegistry(std::vector<CommandSpec> table) : specs(std::move(table)) {
+			for (const CommandSpec& spec : specs) {
+				byName.emplace(spec.name, &spec);
+				for (std::string_view alias : spec.aliases) byName.emplace(alias, &spec);
+				for (const Subcommand& sub : spec.subcommands) subcommandNames.insert(sub.name);
+				if (spec.grammar.empty()) rules.emplace_back(spec.name);
+				for (std::string_view rule : spec.grammar) rules.push_back(std::string(spec.name) + " " + std::string(rule));
+				for (std::string_view alias : spec.aliases)
+					if (alias.front() != '-') rules.emplace_back(alias);
+			}
+			grammarViews.assign(rules.begin(), rules.end());
+		}
+
+		/// The command called `name` (or aliased to it), or nullptr.
+		const CommandSpec* find(std::string_view name) const {
+			auto found = byName.find(name);
+			return found == byName.end() ? nullptr : found->second;
+		}
+
+		bool isSubcommand(std::string_view word) const { return subcommandNames.count(word) != 0; }
+		const std::vector<CommandSpec>& all() const { return specs; }
+		/// Completion rules for every command, each prefixed with the command name.
+		const std::vector<std::string_view>& grammar() const { return grammarViews; }
+
+		/// Runs one command line. Returns false if the command is unknown.
+		bool dispatch(const std::string& line) const {
+			const CommandSpec* spec = find(line.substr(0, line.find(' ')));
+			if (!spec) return false;
+			currentSettings = liveSettings();
+			bool ok = run(*spec, line);
+			if (!ok && currentJob) currentJob->failed = true;
+			terminalWriter.flush();
+			return true;
+		}
+
+		/**
+		 * Starts a command line as a background job and registers its session.
+		 * Returns false if the command is unknown.
+		 */
+		bool dispatchBackground(const std::string& line) const {
+			const CommandSpec* spec = find(line.substr(0, line.find(' ')));
+			if (!spec) return false;
+			if (!spec->background) {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " " << spec->name << " cannot run in the background.\n";
+				if (currentJob) currentJob->failed = true;
+				return true;
+			}
+			auto job = std::make_shared<Job>();
+			job->state.command = line;
+			int id = nextSessionId++;
+			sessions.push_back({id, std::string(spec->name), line, true, job});
+			launchJob(job, id, [this, spec, line] {
+				if (!run(*spec, line)) currentJob->failed = true;
+			});
+			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Started session " << id << ": " << line << "\n";
+			return true;
+		}
+
+	private:
+		bool run(const CommandSpec& spec, const std::string& line) const {
+			std::vector<std::string> stages = splitPipeline(line);
+			std::string command = stages.front();
+			bool json = false;
+			if (spec.records && !takeOutputOption(command, json)) return false;
+			if (stages.size() == 1 && !json) return invoke(spec, line);
+			if (!spec.records) {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " " << spec.name << " produces no records to pipe.\n";
+				return false;
+			}
+			stages.erase(stages.begin());
+			bool ok = true;
+			return runPipeline([&] { ok = invoke(spec, command); }, stages, json) && ok;
+		}
+
+		bool invoke(const CommandSpec& spec, const std::string& line) const {
+			size_t space = line.find(' ');
+			std::string args = (space == std::string::npos) ? "" : line.substr(space + 1);
+			std::istringstream words(args);
+			std::string first;
+			int count = 0;
+			for (std::string word; words >> word; ++count)
+				if (count == 0) first = word;
+			for (const Subcommand& sub : spec.subcommands) {
+				if (sub.name != first) continue;
+				size_t rest = args.find(first) + first.size();
+				return sub.handler(args.substr(std::min(args.size(), args.find_first_not_of(' ', rest))));
+			}
+			if (!spec.handler || count < spec.minArgs || (spec.maxArgs >= 0 && count > spec.maxArgs)) {
+				std::cerr << COLOR_GRAY << "Usage: " << spec.usage << COLOR_RESET << "\n";
+				return false;
+			}
+			return spec.handler(args);
+		}
+
+		std::vector<CommandSpec> specs;
+		std::unordered_map<std::string_view, const CommandSpec*> byName;
+		std::set<std::string_view, std::less<>> subcommandNames;
+		std::vector<std::string> rules;
+		std::vector<std::string_view> grammarViews;
+	};
+
+	const CommandRegistry& commandRegistry();
+
+	// -------------------------------------------------------------------------
+	// Tab Completion Logic
+	// -------------------------------------------------------------------------
+
+	/**
+	 * Scores `candidate` as a fuzzy match for `pattern`: every pattern byte must
+	 * appear in order (case-insensitively). Matches at the start or right after a
+	 * separator and runs of consecutive bytes score higher; skipped bytes cost a
+	 * little. Returns -1 when `pattern` is not a subsequence of `candidate`.
+	 */
+	int fuzzyScore(std::string_view pattern, std::string_view candidate) {
+		auto lower = [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c; };
+		auto separator = [](char c) { return c == '/' || c == '.' || c == '_' || c == '-' || c == ':' || c == ' '; };
+		int score = 0;
+		size_t j = 0, last = std::string::npos;
+		for (size_t i = 0; i < candidate.size() && j < pattern.size(); ++i) {
+			if (lower(candidate[i]) != lower(pattern[j])) continue;
+			int gain = 16;
+			if (i == 0 || separator(candidate[i - 1])) gain += 10;
+			if (last != std::string::npos && i == last + 1) gain += 12;
+			gain -= static_cast<int>(std::min<size_t>(last == std::string::npos ? i : i - last - 1, 8));
+			score += gain;
+			last = i;
+			++j;
+		}
+		return j == pattern.size() ? score : -1;
+	}
+
+	/**
+	 * Tab completion over the command grammar. The grammar is compiled into a word
+	 * trie once; completing a line walks the finished words down the trie and
+	 * fuzzy-matches the word under the cursor against the node's literal words
+	 * and slot source. Prefix matches win over fuzzy ones so Tab can still extend
+	 * a common prefix. Ranking favours the continuations used most in recent
+	 * history; usage is counted once per entry (the newest `usageWindow` at
+	 * first use, then every new one) and kept per preceding-words context.
+	 * Candidates are views, only the best `limit` matches are sorted and copied.
+	 */
+	class CompletionEngine {
+	public:
+		/// Appends candidates for the slot word being typed (`word` may be empty).
+		/// The views must stay valid until the next call of the source.
+		using Source = std::function<void(std::string_view word, std::vector<std::string_view>& out)>;
+
+		struct Result {
+			size_t wordBegin = 0;             ///< Offset of the word the matches replace
+			std::vector<std::string> matches; ///< Best first, at most `limit`
+			size_t total = 0;                 ///< Number of matches before the limit
+			std::string common;               ///< Longest prefix shared by all prefix matches
+			bool prefix = false;              ///< All matches start with the typed word
+		};
+
+		static constexpr size_t limit = 60;
+		static constexpr size_t usageWindow = 4096;
+
+		explicit CompletionEngine(const std::vector<std::string_view>& grammar) : nodes(1) {
+			for (std::string_view rule : grammar) {
+				std::vector<uint32_t> at{0};
+				for (std::string_view word : splitWords(rule)) {
+					std::vector<uint32_t> next;
+					for (uint32_t node : at) {
+						if (word.front() == '<') {
+							next.push_back(slotChild(node, word.substr(1, word.size() - 2)));
+							continue;
+						}
+						for (size_t from = 0, bar; from <= word.size(); from = bar + 1) {
+							bar = std::min(word.find('|', from), word.size());
+							next.push_back(wordChild(node, word.substr(from, bar - from)));
+						}
+					}
+					std::sort(next.begin(), next.end());
+					next.erase(std::unique(next.begin(), next.end()), next.end());
+					at = std::move(next);
+				}
+			}
+		}
+
+		void addSource(std::string_view slot, Source source) {
+			sources[slot] = std::move(source);
+		}
+
+		/// Completes the last word of `line` (the text before the cursor).
+		Result complete(std::string_view line, const CommandHistory& history) {
+			Result result;
+			result.wordBegin = line.find_last_of(' ') + 1;
+			std::string_view word = line.substr(result.wordBegin);
+			std::string context;
+			uint32_t node = 0;
+			for (std::string_view done : splitWords(line.substr(0, result.wordBegin))) {
+				uint32_t next = findWord(node, done);
+				if (next == 0) next = nodes[node].slotNode;
+				if (next == 0) return result;
+				node = next;
+				if (!context.empty()) context += ' ';
+				context += done;
+			}
+
+			candidates.clear();
+			for (const auto& child : nodes[node].words) candidates.push_back(child.first);
+			if (!nodes[node].slot.empty()) {
+				auto source = sources.find(nodes[node].slot);
+				if (source != sources.end()) source->second(word, candidates);
+			}
+
+			countUsage(history);
+			auto counts = usage.find(context);
+			ranked.clear();
+			for (std::string_view candidate : candidates) {
+				bool prefix = candidate.substr(0, word.size()) == word;
+				if (result.prefix && !prefix) continue;
+				int score = prefix ? 1000 : fuzzyScore(word, candidate);
+				if (score < 0) continue;
+				if (prefix && !result.prefix) {
+					ranked.clear();
+					result.prefix = true;
+				}
+				if (counts != usage.end()) {
+					auto used = counts->second.find(candidate);
+					if (used != counts->second.end())
+						for (uint32_t n = used->second; n; n >>= 1) score += 8;
+				}
+				ranked.push_back({score, candidate});
+			}
+
+			auto better = [](const Ranked& a, const Ranked& b) {
+				if (a.score != b.score) return a.score > b.score;
+				return a.text.size() != b.text.size() ? a.text.size() < b.text.size() : a.text < b.text;
+			};
+			// Duplicates (a word offered by two sources) rank next to each other; drop them.
+			size_t keep = std::min(ranked.size(), limit * 2);
+			std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(), better);
+			for (size_t i = 0; i < keep && result.matches.size() < limit; ++i)
+				if (result.matches.empty() || result.matches.back() != ranked[i].text)
+					result.matches.emplace_back(ranked[i].text);
+			result.total = ranked.size();
+			if (result.prefix && !ranked.empty()) {
+				std::string_view common = ranked[0].text;
+				for (const Ranked& r : ranked) {
+					size_t j = word.size();
+					while (j < common.size() && j < r.text.size() && common[j] == r.text[j]) ++j;
+					common = common.substr(0, j);
+				}
+				result.common = common;
+			}
+			return result;
+		}
+
+	private:
+		struct Node {
+			std::vector<std::pair<std::string_view, uint32_t>> words;
+			std::string_view slot;
+			uint32_t slotNode = 0;
+		};
+		struct Ranked {
+			int score;
+			std::string_view text;
+		};
+
+		std::vector<Node> nodes;
+		std::map<std::string_view, Source, std::less<>> sources;
+		std::vector<std::string_view> candidates;
+		std::vector<Ranked> ranked;
+		std::map<std::string, std::map<std::string, uint32_t, std::less<>>, std::less<>> usage;
+		size_t counted = 0;
+		uint64_t generation = 0;
+
+		static std::vector<std::string_view> splitWords(std::string_view text) {
+			std::vector<std::string_view> words;
+			for (size_t pos = 0; pos < text.size(); ) {
+				size_t end = std::min(text.find(' ', pos), text.size());
+				if (end > pos) words.push_back(text.substr(pos, end - pos));
+				pos = end + 1;
+			}
+			return words;
+		}
+
+		uint32_t findWord(uint32_t node, std::string_view word) const {
+			for (const auto& child : nodes[node].words)
+				if (child.first == word) return child.second;
+			return 0;
+		}
+
+		uint32_t wordChild(uint32_t node, std::string_view word) {
+			if (uint32_t found = findWord(node, word)) return found;
+			nodes.emplace_back();
+			nodes[node].words.emplace_back(word, static_cast<uint32_t>(nodes.size() - 1));
+			return static_cast<uint32_t>(nodes.size() - 1);
+		}
+
+		uint32_t slotChild(uint32_t node, std::string_view slot) {
+			if (nodes[node].slotNode) return nodes[node].slotNode;
+			nodes.emplace_back();
+			nodes[node].slot = slot;
+			nodes[node].slotNode = static_cast<uint32_t>(nodes.size() - 1);
+			return nodes[node].slotNode;
+		}
+
+		/// Counts, for each of the first three words of new history entries, the words before it.
+		void countUsage(const CommandHistory& history) {
+			if (history.generation() != generation) {
+				usage.clear();
+				counted = 0;
+				generation = history.generation();
+			}
+			if (counted == 0 && history.size() > usageWindow) counted = history.size() - usageWindow;
+			std::string context;
+			for (; counted < history.size(); ++counted) {
+				context.clear();
+				auto words = splitWords(history[counted]);
+				for (size_t i = 0; i < words.size() && i < 3; ++i) {
+					auto& counts = usage[context];
+					auto it = counts.find(words[i]);
+					if (it == counts.end()) it = counts.emplace(std::string(words[i]), 0).first;
+					++it->second;
+					if (i) context += ' ';
+					context += words[i];
+				}
+			}
+		}
+	};
+
+	// -------------------------------------------------------------------------
+	// Path Completion
+	// -------------------------------------------------------------------------
+
+	/**
+	 * Small LRU cache of directory listings for local path completion. Listings
+	 * are read on a detached worker thread; a lookup waits only `patience` for
+	 * a fresh fetch, so a slow mount just yields no candidates this time and the
+	 * listing is ready on a later Tab. Listings older than `maxAge` are served
+	 * while a refresh runs in the background.
+	 */
+	class DirectoryCache {
+	public:
+		static constexpr size_t capacity = 16;
+		static constexpr size_t maxEntries = 20000;
+		static constexpr std::chrono::milliseconds patience{30};
+		static constexpr std::chrono::seconds maxAge{5};
+
+		/// Entry names in `dir` (directories end in '/'), or nullptr while the listing is not ready.
+		const std::vector<std::string>* list(const std::string& dir) {
+			auto now = std::chrono::steady_clock::now();
+			auto found = index.find(dir);
+			if (found == index.end()) {
+				lru.push_front({dir, {}, false, {}, nullptr});
+				index[dir] = lru.begin();
+				if (lru.size() > capacity) {
+					index.erase(lru.back().dir);
+					lru.pop_back();
+				}
+			} else {
+				lru.splice(lru.begin(), lru, found->second);
+			}
+			Listing& listing = lru.front();
+			if (!listing.fetch && (!listing.ready || now - listing.fetched > maxAge))
+				listing.fetch = start(dir);
+			if (listing.fetch) {
+				std::unique_lock<std::mutex> lock(listing.fetch->mutex);
+				if (!listing.ready) listing.fetch->cv.wait_for(lock, patience, [&] { return listing.fetch->done; });
+				if (listing.fetch->done) {
+					listing.entries = std::move(listing.fetch->entries);
+					listing.ready = true;
+					listing.fetched = now;
+					lock.unlock();
+					listing.fetch.reset();
+				}
+			}
+			return listing.ready ? &listing.entries : nullptr;
+		}
+
+	private:
+		struct Fetch {
+			std::mutex mutex;
+			std::condition_variable cv;
+			bool done = false;
+			std::vector<std::string> entries;
+		};
+		struct Listing {
+			std::string dir;
+			std::vector<std::string> entries;
+			bool ready;
+			std::chrono::steady_clock::time_point fetched;
+			std::shared_ptr<Fetch> fetch;
+		};
+
+		std::list<Listing> lru;
+		std::unordered_map<std::string, std::list<Listing>::iterator> index;
+
+		static std::shared_ptr<Fetch> start(const std::string& dir) {
+			auto fetch = std::make_shared<Fetch>();
+			std::thread([fetch, dir] {
+				std::vector<std::string> entries;
+				std::error_code ec;
+				for (fs::directory_iterator it(dir.empty() ? "." : dir, fs::directory_options::skip_permission_denied, ec), end;
+					 !ec && it != end && entries.size() < maxEntries; it.increment(ec)) {
+					std::string name = it->path().filename().string();
+					std::error_code dirEc;
+					if (it->is_directory(dirEc)) name += '/';
+					entries.push_back(std::move(name));
+				}
+				std::lock_guard<std::mutex> lock(fetch->mutex);
+				fetch->entries = std::move(entries);
+				fetch->done = true;
+				fetch->cv.notify_all();
+			}).detach();
+			return fetch;
+		}
+	};
+
+	/// Completion source for `<path>` slots: entries of the directory named so far.
+	class PathSource {
+	public:
+		void operator()(std::string_view word, std::vector<std::string_view>& out) {
+			size_t slash = word.find_last_of('/');
+			std::string dir(word.substr(0, slash == std::string_view::npos ? 0 : slash + 1));
+			bool hidden = word.substr(dir.size()).substr(0, 1) == ".";
+			const std::vector<std::string>* entries = cache.list(dir);
+			candidates.clear();
+			if (!entries) return;
+			for (const std::string& name : *entries)
+				if (hidden || name.front() != '.') candidates.push_back(dir + name);
+			out.insert(out.end(), candidates.begin(), candidates.end());
+		}
+
+	private:
+		DirectoryCache cache;
+		std::vector<std::string> candidates;
+	};
+
+	// -------------------------------------------------------------------------
+	// Crawled URL Index
+	// -------------------------------------------------------------------------
+
+	/**
+	 * URLs discovered by `ld global` and `enum`, kept for remote completion.
+	 * Paths are grouped by scheme://host. Each host holds a sorted run of
+	 * unique paths plus an unsorted tail of new ones that is merged on the next
+	 * lookup, so recording from crawler threads stays cheap. Listing a directory
+	 * jumps over whole subtrees with binary searches instead of walking them.
+	 * When the stored bytes exceed `budget`, the least recently updated hosts
+	 * are dropped; a single host that alone outgrows it stops taking new paths.
+	 */
+	class CrawlIndex {
+	public:
+		static constexpr size_t budget = 8u << 20;
+		static constexpr size_t maxResults = 5000;
+
+		/// Records an absolute http(s) URL; anything else is ignored.
+		void record(std::string_view url) {
+			size_t hostEnd = hostEndOf(url);
+			if (hostEnd == std::string_view::npos) return;
+			std::string_view path = hostEnd < url.size() ? url.substr(hostEnd) : "/";
+			path = path.substr(0, path.find_first_of("?#"));
+			std::lock_guard<std::mutex> lock(mutex);
+			auto found = hosts.find(url.substr(0, hostEnd));
+			if (found == hosts.end()) {
+				found = hosts.emplace(std::string(url.substr(0, hostEnd)), Host{}).first;
+				bytes += found->first.size() + sizeof(Host);
+			}
+			Host& host = found->second;
+			host.touched = ++clock;
+			size_t cost = path.size() + sizeof(std::string);
+			while (bytes + cost > budget && evictOldest(&host)) {}
+			if (bytes + cost > budget) return;
+			host.paths.emplace_back(path);
+			bytes += cost;
+		}
+
+		/// Appends the known scheme://host prefixes.
+		void hostsTo(std::vector<std::string>& out) {
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const auto& kv : hosts) out.push_back(kv.first);
+		}
+
+		/// Appends the full URLs of the entries directly inside the directory part of `url`.
+		void childrenTo(std::string_view url, std::vector<std::string>& out) {
+			size_t hostEnd = hostEndOf(url);
+			if (hostEnd == std::string_view::npos || hostEnd == url.size()) return;
+			std::string_view origin = url.substr(0, hostEnd);
+			std::string dir(url.substr(hostEnd, url.find_last_of('/') + 1 - hostEnd));
+			std::lock_guard<std::mutex> lock(mutex);
+			auto found = hosts.find(origin);
+			if (found == hosts.end()) return;
+			Host& host = found->second;
+			merge(host);
+			auto it = std::lower_bound(host.paths.begin(), host.paths.end(), dir);
+			for (size_t taken = 0; it != host.paths.end() && it->compare(0, dir.size(), dir) == 0 && taken < maxResults; ++taken) {
+				size_t slash = it->find('/', dir.size());
+				if (slash == std::string::npos) {
+					if (it->size() > dir.size()) out.push_back(std::string(origin) + *it);
+					++it;
+					continue;
+				}
+				std::string child = it->substr(0, slash + 1);
+				out.push_back(std::string(origin) + child);
+				child.back() = '/' + 1;
+				it = std::lower_bound(it, host.paths.end(), child);
+			}
+		}
+
+	private:
+		struct Host {
+			std::vector<std::string> paths;
+			size_t sorted = 0;
+			uint64_t touched = 0;
+		};
+
+		std::mutex mutex;
+		std::map<std::string, Host, std::less<>> hosts;
+		size_t bytes = 0;
+		uint64_t clock = 0;
+
+		static size_t hostEndOf(std::string_view url) {
+			size_t scheme = url.substr(0, 8) == "https://" ? 8 : url.substr(0, 7) == "http://" ? 7 : 0;
+			if (scheme == 0 || url.size() == scheme) return std::string_view::npos;
+			return std::min(url.find('/', scheme), url.size());
+		}
+
+		void merge(Host& host) {
+			if (host.sorted == host.paths.size()) return;
+			auto middle = host.paths.begin() + static_cast<std::ptrdiff_t>(host.sorted);
+			std::sort(middle, host.paths.end());
+			std::inplace_merge(host.paths.begin(), middle, host.paths.end());
+			// std::unique leaves the removed strings moved-from, so count them first.
+			for (size_t i = 1; i < host.paths.size(); ++i)
+				if (host.paths[i] == host.paths[i - 1]) bytes -= host.paths[i].size() + sizeof(std::string);
+			host.paths.erase(std::unique(host.paths.begin(), host.paths.end()), host.paths.end());
+			host.sorted = host.paths.size();
+		}
+
+		bool evictOldest(const Host* keep) {
+			auto oldest = hosts.end();
+			for (auto it = hosts.begin(); it != hosts.end(); ++it)
+				if (&it->second != keep && (oldest == hosts.end() || it->second.touched < oldest->second.touched))
+					oldest = it;
+			if (oldest == hosts.end()) return false;
+			bytes -= oldest->first.size() + sizeof(Host);
+			for (const std::string& path : oldest->second.paths) bytes -= path.size() + sizeof(std::string);
+			hosts.erase(oldest);
+			return true;
+		}
+	};
+
+	static CrawlIndex crawlIndex;
+
+	/// Completion source for remote URLs: known hosts, then the crawled entries of the typed directory.
+	class UrlSource {
+	public:
+		/// `bare` drops the scheme, for `connect global https <host>`.
+		explicit UrlSource(bool bare) : bare(bare) {}
+
+		void operator()(std::string_view word, std::vector<std::string_view>& out) {
+			candidates.clear();
+			if (bare) {
+				size_t slash = word.find('/');
+				if (slash == std::string_view::npos) {
+					crawlIndex.hostsTo(candidates);
+					for (std::string& host : candidates) host = host.substr(host.find("://") + 3) + "/";
+				} else {
+					crawlIndex.childrenTo("http://" + std::string(word), candidates);
+					crawlIndex.childrenTo("https://" + std::string(word), candidates);
+					for (std::string& url : candidates) url = url.substr(url.find("://") + 3);
+				}
+			} else {
+				size_t scheme = word.find("://");
+				if (scheme == std::string_view::npos || word.find('/', scheme + 3) == std::string_view::npos) {
+					crawlIndex.hostsTo(candidates);
+					for (std::string& host : candidates) host += '/';
+				} else {
+					crawlIndex.childrenTo(word, candidates);
+				}
+			}
+			out.insert(out.end(), candidates.begin(), candidates.end());
+		}
+
+	private:
+		bool bare;
+		std::vector<std::string> candidates;
+	};
+
+	/// The completion engine for the interactive prompt, with its slot sources.
+	CompletionEngine& completionEngine() {
+		static CompletionEngine engine = [] {
+			CompletionEngine e(commandRegistry().grammar());
+			e.addSource("config_key", [](std::string_view, std::vector<std::string_view>& out) {
+				for (const auto& kv : config) out.push_back(kv.first);
+			});
+			e.addSource("path", [paths = std::make_shared<PathSource>()](std::string_view word, std::vector<std::string_view>& out) {
+				(*paths)(word, out);
+			});
+			auto urls = std::make_shared<UrlSource>(false);
+			auto source = [urls](std::string_view word, std::vector<std::string_view>& out) { (*urls)(word, out); };
+			e.addSource("url", source);
+			e.addSource("target", source);
+			e.addSource("host", [hosts = std::make_shared<UrlSource>(true)](std::string_view word, std::vector<std::string_view>& out) {
+				(*hosts)(word, out);
+			});
+			return e;
+		}();
+		return engine;
+	}
+
+	// Print possible completions in a nice format
+	void printCompletions(const std::vector<std::string>& completions, size_t total) {
+		if (completions.empty()) return;
+		std::cout << "\n";
+		for (size_t i = 0; i < completions.size(); ++i) {
+			std::cout << "  " << COLOR_BOLD << COLOR_PURPLE << completions[i] << COLOR_RESET;
+			if ((i + 1) % 6 == 0) std::cout << "\n";
+		}
+		if (total > completions.size())
+			std::cout << COLOR_GRAY << "  (+" << total - completions.size() << " more)" << COLOR_RESET;
+		std::cout << "\n";
+		printPrompt();
+		std::cout.flush();
+	}
+
+	// -------------------------------------------------------------------------
+	// Command Implementations
+	// -------------------------------------------------------------------------
+
+	inline bool cmdQuit(const std::string&) { shouldClose = true; return true; }
+	inline bool cmdClear(const std::string&) { clearScreen(); return true; }
+
+	bool cmdReload(const std::string&) {
+		clearScreen();
+		helloBanner();
+		loadingBar("Reloading TCLI config");
+		loadConfig("TCLI");
+		commandHistory.open(config["history_file"]);
+		std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Reload complete.\n";
+		return true;
+	}
+
+	bool cmdSetup(const std::string&) {
+		std::cout << COLOR_YELLOW << "Do you want to create a new TCLI config file? (y/n): " << COLOR_RESET;
+		std::string answer;
+		std::getline(std::cin, answer);
+		std::transform(answer.begin(), answer.end(), answer.begin(), ::tolower);
+		if (answer == "y" || answer == "yes") {
+			if (!saveConfig("TCLI")) return false;
+			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Config file 'TCLI' created.\n";
+		} else {
+			std::cout << COLOR_GRAY << "Config file not created.\n" << COLOR_RESET;
+		}
+		return true;
+	}
+
+	bool cmdConnect(const std::string& args) {
+		if (startsWith(args, "local ")) {
+			std::string path = args.substr(6);
+			if (fs::exists(path) && fs::is_directory(path)) {
+				config["lc_path"] = path;
+				publishSettings();
+				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Connected to local path: " << path << "\n";
+				return true;
+			}
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Local path does not exist or is not a directory: " << path << "\n";
+			return false;
+		} else if (startsWith(args, "global ")) {
+			std::string url = args.substr(7);
+			std::smatch m;
+			static const std::regex proto_domain(R"(^\s*(https?|HTTPS?)\s+([^\s]+))");
+			if (std::regex_match(url, m, proto_domain)) {
+				std::string proto = m[1].str();
+				std::string domain = m[2].str();
+				std::string fullUrl = proto + "://" + domain;
+				config["gl_path"] = fullUrl;
+				publishSettings();
+				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Connected to global URL: " << fullUrl << "\n";
+				return true;
+			}
+			if (startsWith(url, "http://") || startsWith(url, "https://")) {
+				config["gl_path"] = url;
+				publishSettings();
+				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Connected to global URL: " << url << "\n";
+				return true;
+			}
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: connect global <http(s) example.com> or connect global <http(s)://url>\n";
+			return false;
+		}
+		std::cerr << COLOR_GRAY
+				<< "Usage:\n"
+				<< "  connect local <valid-local-path>\n"
+				<< "  connect global <http(s) example.com>\n"
+				<< "  connect global <http(s)://url>\n"
+				<< COLOR_RESET;
+		return false;
+	}
+
+	bool listLocalDirectories() {
+		std::string localPath = settings().localPath;
+		if (!fs::exists(localPath) || !fs::is_directory(localPath)) {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Local path does not exist or is not a directory: " << localPath << "\n";
+			return false;
+		}
+		std::vector<std::string> dirs, files;
+		std::vector<std::future<void>> futures;
+		std::mutex mtx;
+		for (auto& entry : fs::directory_iterator(localPath)) {
+			futures.push_back(runTask([entry, &dirs, &files, &mtx] {
+				if (entry.is_directory()) {
+					std::lock_guard<std::mutex> lock(mtx);
+					dirs.push_back(entry.path().filename().string());
+				} else {
+					std::lock_guard<std::mutex> lock(mtx);
+					files.push_back(entry.path().filename().string());
+				}
+			}));
+		}
+		for (auto& f : futures) f.wait();
+		if (piped()) {
+			for (const auto& d : dirs) emitRecord((fs::path(localPath) / d).string(), 0, true);
+			for (const auto& f : files) emitRecord((fs::path(localPath) / f).string(), 0, false);
+			return true;
+		}
+		std::cout << COLOR_GREEN << "Directories in local path (" << localPath << "):" << COLOR_RESET << "\n";
+		for (const auto& d : dirs)
+			std::cout << "  - " << COLOR_BLUE << d << COLOR_RESET << "\n";
+		for (const auto& f : files)
+			std::cout << "  - " << COLOR_GRAY << f << COLOR_RESET << "\n";
+		return true;
+	}
+
+	std::string combineUrl(const std::string& base, const std::string& relative) {
+		if (relative.empty()) return base;
+		if (startsWith(relative, "http://") || startsWith(relative, "https://")) return relative;
+		std::string b = base;
+		if (!b.empty() && b.back() == '/') b.pop_back();
+		if (!relative.empty() && relative[0] == '/') {
+			std::regex domain_regex(R"(^https?://[^/]+)");
+			std::smatch match;
+			if (std::regex_search(b, match, domain_regex)) return match.str(0) + relative;
+			return b + relative;
+		}
+		return b + "/" + relative;
+	}
+
+	std::vector<std::string> extractLinks(const std::string& html) {
+		std::vector<std::string> links;
+		static const std::regex href_regex(R"###(<a\s+(?:[^>]*?\s+)?href="([^"]*)")###", std::regex::icase);
+		auto begin = std::sregex_iterator(html.begin(), html.end(), href_regex);
+		auto end = std::sregex_iterator();
+		links.reserve(std::distance(begin, end));
+		for (auto i = begin; i != end; ++i)
+			links.push_back((*i)[1].str());
+		return links;
+	}
+
+	/**
+	 * Host name lookups shared by every request. curl runs as a separate
+	 * process per request and would resolve the host each time; instead the
+	 * address is looked up once per host and handed over with --resolve.
+	 */
+	class DnsCache {
+	public:
+		/// curl options pinning the host of `url` to its cached address ("" if unknown).
+		std::string resolveOption(const std::string& url) {
+			size_t scheme = url.find("://");
+			if (scheme == std::string::npos) return "";
+			size_t begin = scheme + 3;
+			size_t end = url.find_first_of("/?#", begin);
+			std::string authority = url.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+			if (authority.empty() || authority.find('@') != std::string::npos || authority[0] == '[') return "";
+			size_t colon = authority.find(':');
+			std::string host = authority.substr(0, colon);
+			std::string port = colon != std::string::npos ? authority.substr(colon + 1) : url.compare(0, scheme, "https") == 0 ? "443" : "80";
+			std::string address = lookup(host);
+			if (address.empty()) return "";
+			return " --resolve \"" + host + ":" + port + ":" + address + "\"";
+		}
+
+	private:
+		struct Entry {
+			std::string address;
+			std::chrono::steady_clock::time_point resolved;
+		};
+
+		std::string lookup(const std::string& host) {
+			auto now = std::chrono::steady_clock::now();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = entries.find(host);
+				if (it != entries.end() && now - it->second.resolved < maxAge) return it->second.address;
+			}
+			std::string address = platform::resolveHost(host);
+			std::lock_guard<std::mutex> lock(mutex);
+			entries[host] = {address, now};
+			return address;
+		}
+
+		static constexpr std::chrono::seconds maxAge{60};
+		std::mutex mutex;
+		std::map<std::string, Entry> entries;
+	};
+	static DnsCache dnsCache;
+
+	std::string httpGet(const std::string& url, const std::string& cookies = "", const std::string& userAgent = "") {
+		if (!checkpoint()) return "";
+		const Settings& s = settings();
+		std::string cmd = "curl -s --max-time " + liveSettings()->curlMaxTime + " -A \"" + (userAgent.empty() ? s.userAgent : userAgent) + "\"" + dnsCache.resolveOption(url);
+		if (!cookies.empty()) cmd += " -b \"" + cookies + "\"";
+		cmd += " \"" + url + "\"";
+		return runTracked(cmd);
+	}
+
+	void enumerateDirectories(const std::string& baseUrl, int depth = 0, int maxDepth = -1) {
+		if (maxDepth == -1) maxDepth = settings().maxEnumDepth;
+		static const std::vector<std::string> commonDirs = {
+			"admin/", "private/", "secret/", "hidden/", "config/", "backup/", "data/", "uploads/", "files/", "tmp/", "test/", "dev/", "logs/", "bin/", "cgi-bin/",
+			".git/", ".svn/", ".env/", ".htaccess", ".htpasswd", "db/", "db_backup/", "old/", "new/", "staging/", "beta/", "alpha/", "api/", "assets/", "images/", "css/", "js/"
+		};
+		static std::shared_mutex visMutex;
+		std::string target = currentTarget ? *currentTarget : std::string();
+		if (depth > maxDepth || !checkpoint() || !workState().claim(baseUrl, depth, target)) return;
+		crawlIndex.record(baseUrl);
+		std::string indent = targetTag() + std::string(depth * 2, ' ');
+		if (!piped()) terminalWriter.push(concat(indent, COLOR_GREEN, "Enumerating: ", baseUrl, COLOR_RESET, "\n"));
+		std::string html = httpGet(baseUrl);
+		if (html.empty()) {
+			if (!jobCancelled() && !piped()) terminalWriter.push(concat(indent, COLOR_YELLOW, "(No response or empty)", COLOR_RESET, "\n"));
+			finishUrl(baseUrl);
+			return;
+		}
+
+		static std::map<std::string, std::string> notFoundCache;
+		std::string notFoundSig;
+		bool cached;
+		{
+			std::shared_lock lock(visMutex);
+			auto it = notFoundCache.find(baseUrl);
+			cached = it != notFoundCache.end();
+			if (cached) notFoundSig = it->second;
+		}
+		if (!cached) {
+			// Fetched without the lock: it waits for a request slot like any other request
+			std::string fake404 = httpGet(combineUrl(baseUrl, "__tcli_fake404__" + std::to_string(rand()) + "/"));
+			notFoundSig = fake404.substr(0, 512);
+			std::unique_lock lock(visMutex);
+			notFoundCache[baseUrl] = notFoundSig;
+		}
+
+		std::vector<std::string> links = extractLinks(html);
+		std::set<std::string> foundDirs;
+		for (const auto& link : links)
+			if (link != "../" && link != "./" && !link.empty() && link.back() == '/' && foundDirs.insert(link).second)
+				emitRecord(combineUrl(baseUrl, link), 0, true);
+
+		std::vector<std::future<void>> futures;
+		std::mutex foundMutex;
+		for (const auto& dir : commonDirs) {
+			if (foundDirs.count(dir)) continue;
+			futures.push_back(runTask([&, dir, indent, notFoundSig] {
+				if (!checkpoint()) return;
+				std::string tryUrl = combineUrl(baseUrl, dir);
+				std::string probe = httpGet(tryUrl);
+				if (probe.empty()) return;
+
+				bool not404 = probe.substr(0, 512) != notFoundSig;
+				bool statusOk = false;
+				int status = 0;
+				{
+					std::string cmd = "curl -s -o /dev/null -w \"%{http_code}\"" + dnsCache.resolveOption(tryUrl) + " \"" + tryUrl + "\"";
+					std::string code = runTracked(cmd);
+					status = std::atoi(code.c_str());
+					statusOk = (status == 200 || status == 301 || status == 302);
+				}
+				bool looksLikeDir = false;
+				static const std::vector<std::string> dirPatterns = {
+					"Index of", "Parent Directory", "<title>Index of", "Directory listing for", "To Parent Directory"
+				};
+				for (const auto& pat : dirPatterns) {
+					if (probe.find(pat) != std::string::npos) {
+						looksLikeDir = true;
+						break;
+					}
+				}
+				std::smatch m;
+				std::string title;
+				if (std::regex_search(probe, m, std::regex("<title>(.*?)</title>", std::regex::icase)))
+					title = m[1].str();
+				bool titleOk = !title.empty() && title.find("404") == std::string::npos && title.find("Not Found") == std::string::npos;
+				bool notRedirect = true;
+				if (probe.find("http-equiv=\"refresh\"") != std::string::npos && probe.find(baseUrl) != std::string::npos)
+					notRedirect = false;
+				int score = 0;
+				if (not404) score++;
+				if (statusOk) score++;
+				if (looksLikeDir) score++;
+				if (titleOk) score++;
+				if (notRedirect) score++;
+				if (score >= 2) {
+					std::lock_guard<std::mutex> lock(foundMutex);
+					foundDirs.insert(dir);
+					crawlIndex.record(tryUrl);
+					if (emitRecord(tryUrl, status, dir.back() == '/', probe.size())) return;
+					terminalWriter.push(concat(indent, COLOR_GREEN, "[ OK ]", COLOR_RESET, " ", dir,
+						"  ", COLOR_GRAY, "(",
+						not404 ? "not404 " : "",
+						statusOk ? "statusOK " : "",
+						looksLikeDir ? "dirPattern " : "",
+						titleOk ? "titleOK " : "",
+						notRedirect ? "notRedirect" : "",
+						")", COLOR_RESET, "\n"));
+				}
+			}));
+		}
+		for (auto& f : futures) f.wait();
+
+		if (depth < maxDepth)
+			for (const auto& dir : foundDirs) workState().schedule(combineUrl(baseUrl, dir), depth + 1, target);
+		finishUrl(baseUrl);
+
+		std::vector<std::future<void>> recFutures;
+		for (const auto& dir : foundDirs) {
+			std::string fullUrl = combineUrl(baseUrl, dir);
+			if (!piped()) terminalWriter.push(concat(indent, COLOR_PURPLE, "[", dir, "]", COLOR_RESET, "\n"));
+			recFutures.push_back(runTask([&, fullUrl, depth, maxDepth] {
+				enumerateDirectories(fullUrl, depth + 1, maxDepth);
+			}));
+		}
+		for (auto& f : recFutures) f.wait();
+	}
+
+	void listGlobalRecursive(const std::string& url, int depth = 0, int maxDepth = -1) {
+		if (maxDepth == -1) maxDepth = settings().maxListDepth;
+		std::string target = currentTarget ? *currentTarget : std::string();
+		if (depth > maxDepth || !checkpoint() || !workState().claim(url, depth, target)) return;
+		std::string indent = targetTag() + std::string(depth * 2, ' ');
+		if (!piped()) terminalWriter.push(concat(indent, COLOR_GREEN, "Listing: ", url, COLOR_RESET, "\n"));
+		std::string html = httpGet(url);
+		if (html.empty()) {
+			finishUrl(url);
+			if (jobCancelled() || piped()) return;
+			terminalWriter.push(concat(indent, COLOR_YELLOW, "(Failed to fetch or empty content)", COLOR_RESET, "\n"));
+			return;
+		}
+		std::vector<std::string> links = extractLinks(html);
+		if (links.empty()) {
+			finishUrl(url);
+			if (piped()) return;
+			terminalWriter.push(concat(indent, COLOR_YELLOW, "(No links found)", COLOR_RESET, "\n"));
+			return;
+		}
+		std::vector<std::string> directories, files;
+		crawlIndex.record(url);
+		for (const auto& link : links) {
+			if (link == "../" || link == "./" || link.empty()) continue;
+			crawlIndex.record(combineUrl(url, link));
+			if (!link.empty() && link.back() == '/') directories.push_back(link);
+			else files.push_back(link);
+		}
+		if (depth < maxDepth)
+			for (const auto& dir : directories) workState().schedule(combineUrl(url, dir), depth + 1, target);
+		finishUrl(url);
+		if (files.empty() && directories.empty()) {
+			if (piped()) return;
+			terminalWriter.push(concat(indent, COLOR_YELLOW, "(No files or directories found)", COLOR_RESET, "\n"));
+			return;
+		}
+		std::string block;
+		for (const auto& file : files) {
+			if (emitRecord(combineUrl(url, file), 0, false)) continue;
+			std::string ext = file.substr(file.find_last_of('.') + 1);
+			std::string_view color = COLOR_GRAY;
+			if (ext == "cpp" || ext == "h" || ext == "hpp" || ext == "c") color = COLOR_BLUE;
+			else if (ext == "sh" || ext == "py" || ext == "pl" || ext == "rb") color = COLOR_GREEN;
+			else if (ext == "txt" || ext == "md") color = COLOR_YELLOW;
+			else if (ext == "zip" || ext == "tar" || ext == "gz" || ext == "rar") color = COLOR_RED;
+			else if (ext == "json" || ext == "xml") color = COLOR_CYAN;
+			else if (ext == "jpg" || ext == "png" || ext == "gif") color = COLOR_PINK;
+			block += indent;
+			block += "  ";
+			block += color;
+			block += file;
+			block += COLOR_RESET;
+			block += '\n';
+		}
+		for (const auto& dir : directories)
+			if (!emitRecord(combineUrl(url, dir), 0, true)) block += concat(indent, COLOR_PURPLE, "[", dir, "]", COLOR_RESET, "\n");
+		if (!block.empty()) terminalWriter.push(std::move(block));
+		std::vector<std::future<void>> futures;
+		for (const auto& dir : directories) {
+			std::string fullUrl = combineUrl(url, dir);
+			futures.push_back(runTask([&, fullUrl, depth, maxDepth] {
+				listGlobalRecursive(fullUrl, depth + 1, maxDepth);
+			}));
+		}
+		for (auto& f : futures) f.wait();
+	}
+
+	/// Splits `--targets <file>` off a command's arguments into `path`; false if absent.
+	bool targetsOption(const std::string& args, std::string& path) {
+		std::istringstream iss(args);
+		std::string flag;
+		if (!(iss >> flag) || flag != "--targets") return false;
+		std::getline(iss >> std::ws, path);
+		return true;
+	}
+
+	/**
+	 * Runs `fn` for every URL listed in `path` (one per line, `#` comments),
+	 * several targets at a time. Each target is its own context: its output
+	 * is tagged with the target and its requests queue separately in the
+	 * shared request budget, which keeps the targets progressing evenly.
+	 * As many targets run at once as the budget has slots. False if the list
+	 * could not be read or names no targets.
+	 */
+	bool runTargets(const std::string& path, const char* what, const std::function<void(const std::string&)>& fn) {
+		std::ifstream file(path);
+		if (!file) {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Could not read target list: " << path << "\n";
+			return false;
+		}
+		std::vector<std::shared_ptr<const std::string>> targets;
+		std::string line;
+		while (std::getline(file, line)) {
+			line.erase(0, line.find_first_not_of(" \t"));
+			line.erase(line.find_last_not_of(" \t\r") + 1);
+			if (!line.empty() && line[0] != '#') targets.push_back(std::make_shared<const std::string>(line));
+		}
+		if (targets.empty()) {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No targets in " << path << "\n";
+			return false;
+		}
+		for (const auto& t : targets) workState().schedule(*t, 0, *t);
+		std::atomic<size_t> next{0};
+		size_t workers = std::min<size_t>(targets.size(), settings().maxRequests);
+		std::vector<std::future<void>> futures;
+		for (size_t i = 0; i < workers; ++i) {
+			futures.push_back(runTask([&] {
+				for (size_t t; (t = next++) < targets.size() && checkpoint();) {
+					currentTarget = targets[t];
+					fn(*targets[t]);
+				}
+				currentTarget.reset();
+			}));
+		}
+		for (auto& f : futures) f.wait();
+		if (jobCancelled()) reportCancelled(what);
+		else if (!piped()) std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " " << what << " finished for " << targets.size() << " target(s).\n";
+		return true;
+	}
+
+	inline bool cmdListLocal(const std::string&) { return listLocalDirectories(); }
+	bool cmdListGlobal(const std::string& args) {
+		std::string path;
+		if (targetsOption(args, path)) {
+			workState().kind = WorkState::Kind::List;
+			return runTargets(path, "Listing", [](const std::string& url) { listGlobalRecursive(url); });
+		}
+		std::string url = args.empty() ? settings().globalPath : args;
+		if (url == "n/a") {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No global URL connected. Use 'connect global <url>' first.\n";
+			return false;
+		}
+		workState().kind = WorkState::Kind::List;
+		listGlobalRecursive(url);
+		if (jobCancelled()) reportCancelled("Listing");
+		return true;
+	}
+
+	bool cmdHelp(const std::string&) {
+		std::cout << COLOR_BOLD << COLOR_CYAN << "TCLI Help\n" << COLOR_RESET;
+		std::cout << COLOR_BOLD << "Available commands:\n" << COLOR_RESET;
+		for (const CommandSpec& spec : commandRegistry().all()) {
+			for (const CommandHelp& line : spec.help) {
+				std::string usage(line.usage);
+				usage.resize(std::max<size_t>(usage.size() + 3, 24), ' ');
+				std::cout << COLOR_PURPLE << "  " << usage << COLOR_RESET << line.text << "\n";
+			}
+		}
+		std::cout << COLOR_BOLD << "Syntax Highlighting:\n" << COLOR_RESET;
+		std::cout << "  " << COLOR_BOLD << "Commands" << COLOR_RESET << ": " << COLOR_PURPLE << "purple bold" << COLOR_RESET << "\n";
+		std::cout << "  " << COLOR_BOLD << "Paths" << COLOR_RESET << ": " << COLOR_YELLOW << "yellow bold" << COLOR_RESET << "\n";
+		std::cout << "  " << COLOR_BOLD << "URLs" << COLOR_RESET << ": " << COLOR_CYAN << "cyan underline" << COLOR_RESET << "\n";
+		std::cout << "  " << COLOR_BOLD << "Numbers" << COLOR_RESET << ": " << COLOR_GREEN << "green" << COLOR_RESET << "\n";
+		std::cout << "  " << COLOR_BOLD << "Strings" << COLOR_RESET << ": " << COLOR_BG_BLU << COLOR_YELLOW << "yellow on blue" << COLOR_RESET << "\n";
+		std::cout << "  " << COLOR_BOLD << "Options/flags" << COLOR_RESET << ": " << COLOR_BG_YEL << COLOR_BLUE << "blue on yellow" << COLOR_RESET << "\n";
+		std::cout << "  " << COLOR_BOLD << "Local/Global" << COLOR_RESET << ": " << COLOR_BG_GRN << COLOR_GRAY << " LOCAL " << COLOR_RESET << " / " << COLOR_BG_CYAN << COLOR_GRAY << " GLOBAL " << COLOR_RESET << "\n";
+		std::cout << COLOR_BOLD << "Tips:\n" << COLOR_RESET;
+		std::cout << "  Use " << COLOR_BOLD << "Tab" << COLOR_RESET << " for auto-completion (now available!)\n";
+		std::cout << "  Use " << COLOR_BOLD << "Up/Down" << COLOR_RESET << " arrows for history navigation\n";
+		std::cout << "  Use " << COLOR_BOLD << "Ctrl-R" << COLOR_RESET << " to search history (Ctrl-R again for older matches)\n";
+		return true;
+	}
+
+	bool cmdEnum(const std::string& args) {
+		std::string path;
+		if (targetsOption(args, path)) {
+			workState().kind = WorkState::Kind::Enum;
+			return runTargets(path, "Enumeration", [](const std::string& url) { enumerateDirectories(url); });
+		}
+		std::string seed = args.empty() ? settings().globalPath : args;
+		if (seed == "n/a") {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No global URL connected. Use 'connect global <url>' first.\n";
+			return false;
+		}
+		workState().kind = WorkState::Kind::Enum;
+		enumerateDirectories(seed);
+		if (jobCancelled()) reportCancelled("Enumeration");
+		return true;
+	}
+
+	/// Deletes the per-path history file, if any; false if it could not be removed.
+	bool removeHistoryFor(const std::string& type, const std::string& path) {
+		auto sanitize = [](const std::string& s) -> std::string {
+			std::string out = s;
+			std::replace(out.begin(), out.end(), '/', '_');
+			std::replace(out.begin(), out.end(), '\\', '_');
+			std::replace(out.begin(), out.end(), ':', '_');
+			std::replace(out.begin(), out.end(), '?', '_');
+			std::replace(out.begin(), out.end(), '*', '_');
+			std::replace(out.begin(), out.end(), '<', '_');
+			std::replace(out.begin(), out.end(), '>', '_');
+			std::replace(out.begin(), out.end(), '|', '_');
+			return out;
+		};
+		std::string histFile = ".tcli_history_" + type + "_" + sanitize(path);
+		if (!fs::exists(histFile)) return true;
+		std::error_code ec;
+		fs::remove(histFile, ec);
+		if (ec) {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Could not remove history file: " << histFile << "\n";
+			return false;
+		}
+		std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Removed history file: " << histFile << "\n";
+		return true;
+	}
+
+	bool cmdBreak(const std::string& args) {
+		std::string arg = args;
+		std::transform(arg.begin(), arg.end(), arg.begin(), ::tolower);
+		if (arg == "local") {
+			if (config["lc_path"] == "n/a") {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No local directory is currently connected.\n";
+				return false;
+			}
+			bool removed = removeHistoryFor("local", config["lc_path"]);
+			config["lc_path"] = "n/a";
+			publishSettings();
+			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Local directory link broken" << (removed ? " and history removed" : "") << ".\n";
+			return removed;
+		}
+		if (arg == "global") {
+			if (config["gl_path"] == "n/a") {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No global URL is currently connected.\n";
+				return false;
+			}
+			bool removed = removeHistoryFor("global", config["gl_path"]);
+			config["gl_path"] = "n/a";
+			publishSettings();
+			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Global URL link broken" << (removed ? " and history removed" : "") << ".\n";
+			return removed;
+		}
+		std::cerr << COLOR_GRAY << "Usage: break local|global" << COLOR_RESET << "\n";
+		return false;
+	}
+
+	/// Parses one `field op value` condition of a `query`; on failure `error` says why.
+	bool parsePredicate(const std::string& word, Predicate& p, std::string& error) {
+		using F = Predicate::Field;
+		using O = Predicate::Op;
+		static const std::vector<std::pair<std::string_view, O>> ops = {
+			{"^=", O::Prefix}, {"!=", O::Ne}, {"<=", O::Le}, {">=", O::Ge}, {"=", O::Eq}, {"<", O::Lt}, {">", O::Gt}, {"~", O::Contains}
+		};
+		static const std::map<std::string, F, std::less<>> fields = {
+			{"status", F::Status}, {"size", F::Size}, {"host", F::Host}, {"path", F::Path},
+			{"url", F::Url}, {"kind", F::Kind}, {"source", F::Source}
+		};
+		size_t at = word.find_first_of("^!<>=~");
+		auto field = at == std::string::npos ? fields.end() : fields.find(std::string_view(word).substr(0, at));
+		if (field == fields.end()) {
+			error = "Expected <field><op><value>, field one of status, size, host, path, url, kind, source: " + word;
+			return false;
+		}
+		auto op = std::find_if(ops.begin(), ops.end(), [&](const auto& o) { return word.compare(at, o.first.size(), o.first) == 0; });
+		if (op == ops.end()) {
+			error = "Unknown operator in: " + word;
+			return false;
+		}
+		p.field = field->second;
+		p.op = op->second;
+		p.text = word.substr(at + op->first.size());
+		if (p.text.size() >= 2 && (p.text.front() == '"' || p.text.front() == '\'') && p.text.back() == p.text.front())
+			p.text = p.text.substr(1, p.text.size() - 2);
+		bool numeric = p.field == F::Status || p.field == F::Size;
+		bool ordered = p.op != O::Contains && p.op != O::Prefix;
+		bool textual = p.op == O::Eq || p.op == O::Ne || !ordered;
+		if (numeric ? !ordered : !textual || (!ordered && (p.field == F::Kind || p.field == F::Source))) {
+			error = "Operator " + std::string(op->first) + " does not apply to " + std::string(field->first);
+			return false;
+		}
+		std::string value = p.text;
+		std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+		if (p.field == F::Status) {
+			p.statusClass = value.size() == 3 && value.compare(1, 2, "xx") == 0 && isdigit(value[0]);
+			if (p.statusClass) value.resize(1);
+		}
+		if (p.field == F::Size) {
+			static const std::string units = "kmg";
+			size_t unit = value.empty() ? std::string::npos : units.find(value.back());
+			if (unit != std::string::npos) value.pop_back();
+			if (!value.empty() && std::all_of(value.begin(), value.end(), ::isdigit))
+				p.number = std::stoull(value) << (unit == std::string::npos ? 0 : 10 * (unit + 1));
+			else value.clear();
+		} else if (p.field == F::Status) {
+			if (!value.empty() && value.size() <= 3 && std::all_of(value.begin(), value.end(), ::isdigit)) p.number = std::stoul(value);
+			else value.clear();
+		} else if (p.field == F::Kind || p.field == F::Source) {
+			static const std::map<std::string, uint64_t> kinds = {{"file", ResultStore::File}, {"dir", ResultStore::Directory}, {"port", ResultStore::Port}};
+			static const std::map<std::string, uint64_t> sources = {{"enum", ResultStore::Enum}, {"ld", ResultStore::List}, {"scan", ResultStore::Scan}};
+			const auto& names = p.field == F::Kind ? kinds : sources;
+			auto found = names.find(value);
+			if (found != names.end()) p.number = found->second;
+			else value.clear();
+		} else if (p.field == F::Host || p.op == O::Contains) {
+			p.text = value;
+		}
+		if (value.empty() && (numeric || p.field == F::Kind || p.field == F::Source)) {
+			error = "Invalid value for " + std::string(field->first) + ": " + p.text
+				+ (p.field == F::Kind ? " (file, dir, port)" : p.field == F::Source ? " (enum, ld, scan)" : "");
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * `query <cond> [and <cond>]... [limit <n>]` over the stored results of
+	 * enum, ld global and scan, e.g. `query status=200 and size>1M and host~corp`.
+	 * It never sends a request. Printed output stops after `limit` rows (100
+	 * unless given) but still counts every match; piped output is unlimited.
+	 */
+	bool cmdQuery(const std::string& args) {
+		std::vector<std::string> words;
+		std::istringstream iss(args);
+		for (std::string word; iss >> word;) words.push_back(word);
+		std::vector<Predicate> where;
+		size_t limit = piped() ? ~size_t(0) : 100;
+		for (size_t i = 0; i < words.size(); ++i) {
+			std::string word = words[i];
+			std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+			if (word == "and" && i > 0 && i + 1 < words.size()) continue;
+			if (word == "limit" && i + 2 == words.size() && std::all_of(words[i + 1].begin(), words[i + 1].end(), ::isdigit)) {
+				limit = std::stoull(words[i + 1]);
+				break;
+			}
+			Predicate p;
+			std::string error;
+			if (!parsePredicate(words[i], p, error)) {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " " << error << "\n"
+						  << COLOR_GRAY << "Usage: query <field><op><value> [and ...] [limit <n>]; ops = != < <= > >= ~ ^=" << COLOR_RESET << "\n";
+				return false;
+			}
+			where.push_back(std::move(p));
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		size_t shown = 0, scanned = 0;
+		std::string url, out;
+		size_t matched = resultStore.select(where, [&](const ResultStore::Row& row) {
+			if (shown == limit) return !piped();
+			++shown;
+			url.assign(row.origin);
+			url += row.path;
+			if (piped()) {
+				currentSink->push({url, row.status, row.kind == ResultStore::Directory, nullptr, row.size});
+				return !jobCancelled();
+			}
+			appendRecordLine(out, url, row.status, row.kind == ResultStore::Directory, {}, row.size);
+			if (out.size() >= 64 * 1024) {
+				std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+				out.clear();
+			}
+			return true;
+		}, scanned);
+		if (piped()) return true;
+		std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+		char ms[32];
+		std::snprintf(ms, sizeof(ms), "%.1f ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " " << matched << " result" << (matched == 1 ? "" : "s")
+				  << (shown < matched ? " (first " + std::to_string(shown) + " shown, add `limit <n>` for more)" : "")
+				  << COLOR_GRAY << " - " << scanned << " rows examined in " << ms << COLOR_RESET << "\n";
+		return true;
+	}
+
+	// -------------------------------------------------------------------------
+	// Syntax Highlighting Lexer
+	// -------------------------------------------------------------------------
+
+	enum class TokenKind { Plain, Url, Path, String, Flag, Number, Hex, Ip, Email, Assign, Word };
+
+	struct Token {
+		TokenKind kind;
+		size_t begin;
+		size_t length;
+		size_t reach;   ///< Last offset the lexer looked at to classify this token (size() = end of input)
+	};
+
+	inline bool isAsciiDigit(char c) { return c >= '0' && c <= '9'; }
+	inline bool isAsciiAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+	inline bool isHexDigit(char c) { return isAsciiDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+	inline bool isWordChar(char c) { return isAsciiAlpha(c) || isAsciiDigit(c) || c == '_'; }
+	inline bool isSpaceChar(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+	inline bool isFlagChar(char c) { return isWordChar(c) || c == '-'; }
+	inline bool isEmailLocalChar(char c) { return isWordChar(c) || c == '.' || c == '+' || c == '-'; }
+	inline bool isEmailLabelChar(char c) { return isAsciiAlpha(c) || isAsciiDigit(c) || c == '-'; }
+	inline bool isEmailTailChar(char c) { return isEmailLabelChar(c) || c == '.'; }
+	inline bool isQuoteChar(char c) { return c == '"' || c == '\''; }
+
+	/**
+	 * Hand-written single-pass replacement for the old regex cascade. Rules are
+	 * tried in the same precedence the regexes had (url, path, string, flag,
+	 * number, hex, ip, email, '=', word) and each one only looks at the text its
+	 * pattern could cover from `pos`, so lexing a line is linear in its length.
+	 * Because numbers win over IPs (as they always did), a dotted quad still
+	 * lexes as a number followed by plain dots.
+	 *
+	 * Classification only ever looks forward from `pos`, and each token records
+	 * how far it looked (`reach`) so an edit only invalidates the tokens that saw
+	 * it. The one unbounded lookahead, an opening quote searching for its closing
+	 * quote, is reported through unclosedQuote() instead of through `reach`.
+	 */
+	class InputLexer {
+	public:
+		explicit InputLexer(std::string_view text) : text(text) {}
+
+		Token next(size_t pos) {
+			reach = pos;
+			Token tok = classify(pos);
+			tok.reach = reach;
+			return tok;
+		}
+
+		/// Offset of the quote whose closing quote was not found, or npos.
+		size_t unclosedQuote() const { return openQuote; }
+
+	private:
+		std::string_view text;
+		size_t reach = 0;
+		size_t openQuote = std::string_view::npos;
+		// End of the last digit / email-local run that failed to match; every
+		// position inside such a run fails the same way, so it is not rescanned.
+		size_t numberFailEnd = 0;
+		size_t emailFailEnd = 0;
+		size_t emailFailReach = 0;
+
+		Token classify(size_t pos) {
+			size_t len;
+			if ((len = matchUrl(pos))) return {TokenKind::Url, pos, len, 0};
+			if ((len = matchPath(pos))) return {TokenKind::Path, pos, len, 0};
+			if ((len = matchString(pos))) return {TokenKind::String, pos, len, 0};
+			if ((len = matchFlag(pos))) return {TokenKind::Flag, pos, len, 0};
+			if ((len = matchNumber(pos))) return {TokenKind::Number, pos, len, 0};
+			if ((len = matchHex(pos))) return {TokenKind::Hex, pos, len, 0};
+			if ((len = matchIp(pos))) return {TokenKind::Ip, pos, len, 0};
+			if ((len = matchEmail(pos))) return {TokenKind::Email, pos, len, 0};
+			if (text[pos] == '=') return {TokenKind::Assign, pos, 1, 0};
+			if ((len = matchWord(pos))) return {TokenKind::Word, pos, len, 0};
+			return {TokenKind::Plain, pos, 1, 0};
+		}
+
+		void note(size_t pos) { reach = std::max(reach, std::min(pos, text.size())); }
+		size_t runEnd(size_t pos, bool (*pred)(char)) {
+			while (pos < text.size() && pred(text[pos])) ++pos;
+			note(pos);
+			return pos;
+		}
+		bool expect(size_t& pos, std::string_view literal) {
+			for (char ch : literal) {
+				note(pos);
+				if (pos >= text.size() || text[pos] != ch) return false;
+				++pos;
+			}
+			return true;
+		}
+		bool boundaryAt(size_t pos) {
+			note(pos);
+			return pos == text.size() || !isWordChar(text[pos]);
+		}
+
+		// https?://[^\s]+
+		size_t matchUrl(size_t pos) {
+			size_t head = pos;
+			if (!expect(head, "http")) return 0;
+			if (head < text.size() && text[head] == 's') ++head;
+			if (!expect(head, "://")) return 0;
+			size_t end = head;
+			while (end < text.size() && !isSpaceChar(text[end])) ++end;
+			note(end);
+			return end > head ? end - pos : 0;
+		}
+		// (/[^ ]+)+
+		size_t matchPath(size_t pos) {
+			if (text[pos] != '/') return 0;
+			note(pos + 1);
+			if (pos + 1 >= text.size() || text[pos + 1] == ' ') return 0;
+			size_t end = text.find(' ', pos + 1);
+			if (end == std::string_view::npos) end = text.size();
+			note(end);
+			return end - pos;
+		}
+		// ["'][^"']*["']
+		size_t matchString(size_t pos) {
+			if (!isQuoteChar(text[pos])) return 0;
+			size_t close = text.find_first_of("\"'", pos + 1);
+			if (close == std::string_view::npos) {
+				openQuote = pos;
+				return 0;
+			}
+			note(close);
+			return close - pos + 1;
+		}
+		// --?[a-zA-Z0-9_-]+
+		size_t matchFlag(size_t pos) {
+			if (text[pos] != '-') return 0;
+			size_t end = runEnd(pos + 1, isFlagChar);
+			return end > pos + 1 ? end - pos : 0;
+		}
+		// \b\d+\b
+		size_t matchNumber(size_t pos) {
+			if (!isAsciiDigit(text[pos])) return 0;
+			if (pos < numberFailEnd) {
+				note(numberFailEnd);
+				return 0;
+			}
+			size_t end = runEnd(pos, isAsciiDigit);
+			if (!boundaryAt(end)) {
+				numberFailEnd = end;
+				return 0;
+			}
+			return end - pos;
+		}
+		// \b0x[0-9a-fA-F]+\b
+		size_t matchHex(size_t pos) {
+			note(pos + 1);
+			if (!text.substr(pos).starts_with("0x")) return 0;
+			size_t end = runEnd(pos + 2, isHexDigit);
+			return end > pos + 2 && boundaryAt(end) ? end - pos : 0;
+		}
+		// \b\d{1,3}(\.\d{1,3}){3}\b, including the regex's backtracking over octet widths
+		size_t matchIp(size_t pos) {
+			size_t end = matchOctets(pos, 0);
+			return end == std::string_view::npos ? 0 : end - pos;
+		}
+		size_t matchOctets(size_t pos, int octet) {
+			size_t digits = runEnd(pos, isAsciiDigit) - pos;
+			for (size_t width = std::min<size_t>(digits, 3); width >= 1; --width) {
+				size_t end = pos + width;
+				if (octet == 3) {
+					if (boundaryAt(end)) return end;
+				} else if (end < text.size() && text[end] == '.') {
+					size_t r = matchOctets(end + 1, octet + 1);
+					if (r != std::string_view::npos) return r;
+				}
+			}
+			return std::string_view::npos;
+		}
+		// [a-zA-Z0-9_.+-]+@[a-zA-Z0-9-]+\.[a-zA-Z0-9-.]+
+		size_t matchEmail(size_t pos) {
+			if (!isEmailLocalChar(text[pos])) return 0;
+			if (pos < emailFailEnd) {
+				note(emailFailReach);
+				return 0;
+			}
+			size_t at = runEnd(pos, isEmailLocalChar);
+			if (at < text.size() && text[at] == '@') {
+				size_t dot = runEnd(at + 1, isEmailLabelChar);
+				if (dot > at + 1 && dot < text.size() && text[dot] == '.') {
+					size_t end = runEnd(dot + 1, isEmailTailChar);
+					if (end > dot + 1) return end - pos;
+				}
+			}
+			emailFailEnd = at;
+			emailFailReach = reach;
+			return 0;
+		}
+		// \b[a-zA-Z_][a-zA-Z0-9_]*\b
+		size_t matchWord(size_t pos) {
+			if (!isAsciiAlpha(text[pos]) && text[pos] != '_') return 0;
+			return runEnd(pos, isWordChar) - pos;
+		}
+	};
+
+	/// Appends `tok` to `tokens`, folding adjacent plain characters into one token.
+	inline void pushToken(std::vector<Token>& tokens, const Token& tok) {
+		if (tok.kind == TokenKind::Plain && !tokens.empty() && tokens.back().kind == TokenKind::Plain
+			&& tokens.back().begin + tokens.back().length == tok.begin) {
+			tokens.back().length += tok.length;
+			tokens.back().reach = std::max(tokens.back().reach, tok.reach);
+		} else {
+			tokens.push_back(tok);
+		}
+	}
+
+	/// Splits an input line into highlight tokens.
+	std::vector<Token> lexInput(std::string_view buffer) {
+		std::vector<Token> tokens;
+		InputLexer lexer(buffer);
+		for (size_t pos = 0; pos < buffer.size(); pos = tokens.back().begin + tokens.back().length)
+			pushToken(tokens, lexer.next(pos));
+		return tokens;
+	}
+
+	struct TokenStyle {
+		std::string_view style;   ///< ANSI prefix; empty for unstyled text
+		std::string_view label;   ///< Replacement text (" LOCAL "), or empty to print the token itself
+	};
+
+	/// Resolves how a token is drawn: its ANSI prefix and, for keywords like `local`, its badge text.
+	/// Every token is plain text when colors are off.
+	TokenStyle styleOf(std::string_view buffer, const Token& tok) {
+		if (!colorEnabled()) return {"", ""};
+		static const std::set<std::string, std::less<>> options = {
+			"-h", "--help", "-v", "--version", "-a", "--all", "-r", "--recursive",
+			"--sql", "--xss", "--cmd", "--randomize"
+		};
+		static const std::string badgeLocal = concat(COLOR_BG_GRN, COLOR_GRAY);
+		static const std::string badgeGlobal = concat(COLOR_BG_CYAN, COLOR_GRAY);
+		static const std::string badgeUser = concat(COLOR_BG_MAG, COLOR_GRAY);
+		static const std::string badgeAdmin = concat(COLOR_BG_RED, COLOR_BOLD, COLOR_GRAY);
+		static const std::string boldYellow = concat(COLOR_BOLD, COLOR_YELLOW);
+		static const std::string boldCyan = concat(COLOR_BOLD, COLOR_CYAN);
+		static const std::string boldPink = concat(COLOR_BOLD, COLOR_PINK);
+		static const std::string boldBlue = concat(COLOR_BOLD, COLOR_BLUE);
+		static const std::string boldPurple = concat(COLOR_BOLD, COLOR_PURPLE);
+		static const std::string boldGreen = concat(COLOR_BOLD, COLOR_GREEN);
+		static const std::string boldRed = concat(COLOR_BOLD, COLOR_RED);
+		static const std::string flagStyle = concat(COLOR_BG_YEL, COLOR_BLUE);
+		static const std::map<std::string, TokenStyle, std::less<>> keywords = {
+			{"local", {badgeLocal, " LOCAL "}},
+			{"global", {badgeGlobal, " GLOBAL "}},
+			{"user", {badgeUser, " USER "}},
+			{"admin", {badgeAdmin, " ADMIN "}},
+			{"path", {boldYellow, ""}},
+			{"url", {boldCyan, ""}},
+			{"mac", {boldPink, ""}},
+			{"ip", {boldCyan, ""}},
+			{"dns", {boldBlue, ""}},
+			{"list", {boldPink, ""}},
+			{"kill", {boldPink, ""}},
+			{"resume", {boldPink, ""}},
+			{"show", {boldPink, ""}},
+			{"reverse_shell", {boldPink, ""}},
+			{"keylogger", {boldPink, ""}}
+		};
+		static const std::string styles[] = {
+			"",                                                // Plain
+			concat(COLOR_UNDER, COLOR_CYAN),                   // Url
+			concat(COLOR_BOLD, COLOR_YELLOW),                  // Path
+			concat(COLOR_BG_BLU, COLOR_YELLOW),                // String
+			flagStyle,                                         // Flag
+			std::string(COLOR_GREEN),                          // Number
+			std::string(COLOR_ORANGE),                         // Hex
+			concat(COLOR_BG_CYAN, COLOR_BOLD, COLOR_GRAY),     // Ip
+			std::string(COLOR_PINK),                           // Email
+			boldRed,                                           // Assign
+		};
+		if (tok.kind != TokenKind::Word) return {styles[static_cast<size_t>(tok.kind)], ""};
+		std::string_view text = buffer.substr(tok.begin, tok.length);
+		const CommandRegistry& registry = commandRegistry();
+		if (registry.find(text)) return {boldPurple, ""};
+		if (options.count(text)) return {flagStyle, ""};
+		if (auto kw = keywords.find(text); kw != keywords.end()) return kw->second;
+		if (registry.isSubcommand(text)) return {flagStyle, ""};
+		if (text == "true") return {boldGreen, ""};
+		if (text == "false") return {boldRed, ""};
+		return {"", ""};
+	}
+
+	/// Appends the colored form of one token to `out`.
+	void appendToken(std::string& out, std::string_view buffer, const Token& tok) {
+		TokenStyle ts = styleOf(buffer, tok);
+		std::string_view text = ts.label.empty() ? buffer.substr(tok.begin, tok.length) : ts.label;
+		if (ts.style.empty()) {
+			out += text;
+			return;
+		}
+		out += ts.style;
+		out += text;
+		out += COLOR_RESET;
+	}
+
+	std::string highlightInput(const std::string& buffer) {
+		std::string result;
+		result.reserve(buffer.size() * 2);
+		for (const auto& tok : lexInput(buffer))
+			appendToken(result, buffer, tok);
+		return result;
+	}
+
+	// -------------------------------------------------------------------------
+	// Incremental Line Highlighting
+	// -------------------------------------------------------------------------
+
+	/**
+	 * Token list for the line being edited, kept in step with the buffer so a
+	 * keystroke only re-lexes the tokens around it. Re-lexing starts at the first
+	 * token whose lookahead reached the edit and stops as soon as it lands on an
+	 * old token boundary past the edit: lexing only looks forward, so every token
+	 * from there on is unchanged apart from its offset.
+	 */
+	class LineHighlighter {
+	public:
+		/// Where the drawn line first differs after an update.
+		struct Damage {
+			size_t token;    ///< First token whose drawing changed
+			size_t byte;     ///< Buffer offset inside that token where the change starts
+			size_t column;   ///< Display column of `byte`
+		};
+
+		void reset(std::string_view buffer) {
+			entries.clear();
+			openQuote = std::string_view::npos;
+			update(buffer, 0, 0, buffer.size(), true);
+		}
+
+		/**
+		 * Re-lexes after `removed` bytes at `at` were replaced by `inserted` bytes
+		 * (`buffer` is the new text). `quoteTouched` says whether any inserted or
+		 * removed byte was a quote, which is the only edit that can change the
+		 * outcome of an earlier unclosed quote.
+		 */
+		Damage update(std::string_view buffer, size_t at, size_t removed, size_t inserted, bool quoteTouched) {
+			const ptrdiff_t delta = static_cast<ptrdiff_t>(inserted) - static_cast<ptrdiff_t>(removed);
+			const size_t editEnd = at + inserted;
+
+			size_t first = std::partition_point(entries.begin(), entries.end(),
+				[at](const Entry& e) { return e.reachMax < at; }) - entries.begin();
+			if (quoteTouched && openQuote < at) {
+				size_t q = tokenAt(openQuote);
+				first = std::min(first, q);
+			}
+			size_t start = first < entries.size() ? entries[first].tok.begin
+				: entries.empty() ? 0 : entries.back().tok.begin + entries.back().tok.length;
+
+			InputLexer lexer(buffer);
+			std::vector<Token> fresh;
+			size_t resume = entries.size();
+			size_t k = first;
+			size_t pos = start;
+			while (pos < buffer.size()) {
+				if (pos >= editEnd) {
+					size_t oldPos = pos - delta;
+					while (k < entries.size() && entries[k].tok.begin < oldPos) ++k;
+					if (k < entries.size() && entries[k].tok.begin == oldPos) {
+						resume = k;
+						break;
+					}
+				}
+				Token tok = lexer.next(pos);
+				pos = tok.begin + tok.length;
+				if (!fresh.empty()) pushToken(fresh, tok);
+				else if (first > 0 && tok.kind == TokenKind::Plain && entries[first - 1].tok.kind == TokenKind::Plain) {
+					fresh.push_back(entries[--first].tok);
+					pushToken(fresh, tok);
+				} else fresh.push_back(tok);
+			}
+
+			size_t resumeOld = resume < entries.size() ? entries[resume].tok.begin : std::string_view::npos;
+			if (resume < entries.size() && !fresh.empty() && fresh.back().kind == TokenKind::Plain
+				&& entries[resume].tok.kind == TokenKind::Plain) {
+				fresh.back().length += entries[resume].tok.length;
+				fresh.back().reach = std::max(fresh.back().reach, entries[resume].tok.reach + delta);
+				++resume;
+			}
+
+			size_t oldQuote = openQuote;
+			if (lexer.unclosedQuote() != std::string_view::npos && lexer.unclosedQuote() < pos)
+				openQuote = lexer.unclosedQuote();
+			else if (oldQuote != std::string_view::npos && oldQuote >= resumeOld)
+				openQuote = oldQuote + delta;
+			else if (oldQuote != std::string_view::npos && oldQuote >= start)
+				openQuote = std::string_view::npos;
+
+			// Skip re-lexed tokens that came out identical and entirely before the edit.
+			size_t same = 0;
+			while (same < fresh.size() && first + same < resume) {
+				const Token& a = fresh[same];
+				const Token& b = entries[first + same].tok;
+				if (a.kind != b.kind || a.begin != b.begin || a.length != b.length || a.begin + a.length > at) break;
+				++same;
+			}
+			size_t partialByte = std::string_view::npos;
+			if (same < fresh.size() && first + same < resume) {
+				const Token& a = fresh[same];
+				const Token& b = entries[first + same].tok;
+				const TokenStyle& bs = entries[first + same].style;
+				// Same token extended or trimmed in place and drawn the same way: only redraw from the edit.
+				if (a.kind == b.kind && a.begin == b.begin && bs.label.empty()
+					&& (a.kind != TokenKind::Word || sameStyle(styleOf(buffer, a), bs)))
+					partialByte = std::max(a.begin, std::min(at, a.begin + std::min(a.length, b.length)));
+			}
+
+			std::vector<Entry> replaced;
+			replaced.reserve(fresh.size());
+			for (const auto& tok : fresh) {
+				TokenStyle ts = styleOf(buffer, tok);
+				replaced.push_back({tok, ts, 0, ts.label.empty() ? tok.length : ts.label.size(), 0});
+			}
+			entries.erase(entries.begin() + first, entries.begin() + resume);
+			entries.insert(entries.begin() + first, replaced.begin(), replaced.end());
+			size_t shiftFrom = first + replaced.size();
+			for (size_t i = shiftFrom; i < entries.size(); ++i) {
+				entries[i].tok.begin += delta;
+				entries[i].tok.reach += delta;
+			}
+			for (size_t i = first; i < entries.size(); ++i) {
+				const Entry* prev = i ? &entries[i - 1] : nullptr;
+				entries[i].column = prev ? prev->column + prev->width : 0;
+				entries[i].reachMax = prev ? std::max(prev->reachMax, entries[i].tok.reach) : entries[i].tok.reach;
+			}
+			Damage damage{first + same, buffer.size(), 0};
+			if (damage.token < entries.size())
+				damage.byte = partialByte != std::string_view::npos ? partialByte : entries[damage.token].tok.begin;
+			damage.column = columnOf(damage.byte);
+			return damage;
+		}
+
+		size_t tokenCount() const { return entries.size(); }
+		size_t width() const { return entries.empty() ? 0 : entries.back().column + entries.back().width; }
+
+		/// Display column of a buffer offset (badges like " LOCAL " are wider than their word).
+		size_t columnOf(size_t byte) const {
+			size_t i = tokenAt(byte);
+			if (i == entries.size()) return width();
+			const Entry& e = entries[i];
+			size_t offset = byte - e.tok.begin;
+			if (offset == 0 || e.width == e.tok.length) return e.column + offset;
+			return e.column + std::min(offset + (e.width - e.tok.length) / 2, e.width);
+		}
+
+		/// Calls `emit(text, style)` for each drawn piece of the line from `damage` to the end.
+		template <class Emit>
+		void paint(std::string_view buffer, const Damage& damage, Emit&& emit) const {
+			for (size_t i = damage.token; i < entries.size(); ++i) {
+				const Entry& e = entries[i];
+				if (!e.style.label.empty()) {
+					emit(e.style.label, e.style.style);
+					continue;
+				}
+				size_t skip = i == damage.token && damage.byte > e.tok.begin ? damage.byte - e.tok.begin : 0;
+				emit(buffer.substr(e.tok.begin + skip, e.tok.length - skip), e.style.style);
+			}
+		}
+
+	private:
+		struct Entry {
+			Token tok;
+			TokenStyle style;
+			size_t column;     ///< Display column of the token's first cell
+			size_t width;      ///< Display width of the token
+			size_t reachMax;   ///< Largest reach among this token and all before it
+		};
+		std::vector<Entry> entries;
+		size_t openQuote = std::string_view::npos;
+
+		static bool sameStyle(const TokenStyle& a, const TokenStyle& b) {
+			return a.style == b.style && a.label == b.label;
+		}
+
+		/// Index of the token containing `byte`, or tokenCount() past the end.
+		size_t tokenAt(size_t byte) const {
+			return std::partition_point(entries.begin(), entries.end(),
+				[byte](const Entry& e) { return e.tok.begin + e.tok.length <= byte; }) - entries.begin();
+		}
+	};
+
+	// -------------------------------------------------------------------------
+	// Frame Renderer
+	// -------------------------------------------------------------------------
+
+	/**
+	 * Draws the input line as a grid of cells. Each frame is painted into a
+	 * reusable cell buffer (only from the highlighter's damage column on), diffed
+	 * against what is on screen, and the changed cells plus the cursor placement
+	 * leave in a single write. Positions are display columns counted from the
+	 * start of the input; rows follow from the terminal width.
+	 */
+	class FrameRenderer {
+	public:
+		/// Starts an empty frame at the terminal's current cursor position.
+		void reset() {
+			shown.clear();
+			termCol = 0;
+			pen = 0;
+			width = currentWidth();
+		}
+
+		/// Brings the screen up to date with the highlighter and places the cursor.
+		void draw(const LineHighlighter& hl, std::string_view buffer, const LineHighlighter::Damage& damage, size_t cursorCol) {
+			compose(hl, buffer, damage, cursorCol);
+			flush();
+		}
+
+		/// Builds the bytes for the next frame without writing them.
+		const std::string& compose(const LineHighlighter& hl, std::string_view buffer, LineHighlighter::Damage damage, size_t cursorCol) {
+			out.clear();
+			if (checkResize()) damage = {0, 0, 0};
+			paintFrom(damage.column, [&](auto&& emit) { hl.paint(buffer, damage, emit); }, cursorCol);
+			return out;
+		}
+
+		/// Redraws the whole line from an arbitrary painter, e.g. the history search prompt.
+		/// `paint` receives an `emit(text, style)` callback.
+		template <class Paint>
+		void drawWith(Paint&& paint, size_t cursorCol) {
+			out.clear();
+			checkResize();
+			paintFrom(0, paint, cursorCol);
+			flush();
+		}
+
+		void placeCursor(size_t col) {
+			out.clear();
+			moveTo(col);
+			flush();
+		}
+
+		/// Leaves the cursor at the start of the line below the input.
+		void finish() {
+			out.clear();
+			moveTo(shown.size());
+			resetPen();
+			if (termCol % width != 0 || termCol == 0) out += "\n";
+			flush();
+		}
+
+	private:
+		struct Cell {
+			char ch;
+			uint8_t style;
+			bool operator==(const Cell&) const = default;
+		};
+		std::vector<Cell> shown;              ///< Cells currently on screen
+		std::vector<Cell> frame;              ///< Cells of the next frame from the damage column on
+		std::vector<std::string_view> styles{""};
+		std::string out;
+		size_t termCol = 0;
+		size_t width = 80;
+		uint8_t pen = 0;                      ///< Style currently active on the terminal
+
+		static size_t currentWidth() { return static_cast<size_t>(std::max(platform::terminalWidth(), 1)); }
+
+		/// On a resize the row math for what is on screen no longer holds: clear it and start over.
+		bool checkResize() {
+			size_t w = currentWidth();
+			if (w == width) return false;
+			moveTo(0);
+			resetPen();
+			out += "\033[J";
+			shown.clear();
+			width = w;
+			return true;
+		}
+
+		/// Paints the frame from column `from` on, diffs it against the screen and places the cursor.
+		template <class Paint>
+		void paintFrom(size_t from, Paint&& paint, size_t cursorCol) {
+			from = std::min(from, shown.size());
+			frame.clear();
+			paint([this](std::string_view text, std::string_view style) {
+				uint8_t id = intern(style);
+				for (char ch : text) frame.push_back({ch, id});
+			});
+
+			// Send changed runs; short unchanged gaps are rewritten rather than skipped.
+			const size_t gap = 8;
+			size_t i = 0;
+			while (i < frame.size()) {
+				size_t col = from + i;
+				if (col < shown.size() && frame[i] == shown[col]) {
+					++i;
+					continue;
+				}
+				size_t last = i;
+				for (size_t j = i + 1; j < frame.size() && j - last <= gap; ++j)
+					if (from + j >= shown.size() || !(frame[j] == shown[from + j])) last = j;
+				moveTo(col);
+				for (size_t j = i; j <= last; ++j) put(frame[j]);
+				i = last + 1;
+			}
+			size_t end = from + frame.size();
+			if (end < shown.size()) {
+				moveTo(end);
+				resetPen();
+				out += "\033[J";
+			}
+			shown.resize(from);
+			shown.insert(shown.end(), frame.begin(), frame.end());
+			moveTo(cursorCol);
+			resetPen();
+		}
+
+		uint8_t intern(std::string_view style) {
+			for (size_t i = 0; i < styles.size(); ++i)
+				if (styles[i] == style) return static_cast<uint8_t>(i);
+			styles.push_back(style);
+			return static_cast<uint8_t>(styles.size() - 1);
+		}
+
+		void resetPen() {
+			if (!pen) return;
+			out += COLOR_RESET;
+			pen = 0;
+		}
+
+		void put(const Cell& cell) {
+			if (cell.style != pen) {
+				resetPen();
+				out += styles[cell.style];
+				pen = cell.style;
+			}
+			out += cell.ch;
+			++termCol;
+			// Step off the right margin so the terminal's pending-wrap state never skews columns.
+			if (termCol % width == 0) {
+				resetPen();
+				out += "\r\n";
+			}
+		}
+
+		/// One cursor move: relative rows (scroll-safe) and an absolute column.
+		void moveTo(size_t col) {
+			size_t fromRow = termCol / width, toRow = col / width;
+			if (toRow < fromRow) out += "\033[" + std::to_string(fromRow - toRow) + "A";
+			else if (toRow > fromRow) out += "\033[" + std::to_string(toRow - fromRow) + "B";
+			if (col % width != termCol % width) out += "\033[" + std::to_string(col % width + 1) + "G";
+			termCol = col;
+		}
+
+		void flush() {
+			if (out.empty()) return;
+			std::cout.flush();
+			platform::writeOutput(out);
+			out.clear();
+		}
+	};
+
+	// -------------------------------------------------------------------------
+	// History Search (Ctrl-R)
+	// -------------------------------------------------------------------------
+
+	/**
+	 * Trigram index over the command history for reverse incremental search.
+	 * History only grows between clears, so new entries are indexed lazily the
+	 * next time a search runs. Each trigram keeps the ascending ids of the entries that
+	 * contain it; a lookup walks the posting list of the query's rarest trigram
+	 * from the newest end and only verifies those candidates. Queries shorter
+	 * than three bytes fall back to a backwards scan, which finds common short
+	 * strings within the last few entries.
+	 */
+	class HistoryIndex {
+	public:
+		static constexpr size_t npos = std::string::npos;
+
+		/// Newest entry with id below `before` that contains `query`, or npos.
+		size_t findBefore(const CommandHistory& history, std::string_view query, size_t before) {
+			before = std::min(before, history.size());
+			if (query.size() < 3) {
+				for (size_t i = before; i-- > 0; )
+					if (history[i].find(query) != std::string::npos) return i;
+				return npos;
+			}
+			sync(history);
+			const std::vector<uint32_t>* rarest = nullptr;
+			for (size_t i = 0; i + 3 <= query.size(); ++i) {
+				auto it = postings.find(trigram(query, i));
+				if (it == postings.end()) return npos;
+				if (!rarest || it->second.size() < rarest->size()) rarest = &it->second;
+			}
+			for (auto it = std::lower_bound(rarest->begin(), rarest->end(), before); it != rarest->begin(); ) {
+				--it;
+				if (history[*it].find(query) != std::string::npos) return *it;
+			}
+			return npos;
+		}
+
+	private:
+		std::unordered_map<uint32_t, std::vector<uint32_t>> postings;
+		size_t indexed = 0;
+		uint64_t generation = 0;
+
+		static uint32_t trigram(std::string_view s, size_t i) {
+			return static_cast<uint32_t>(static_cast<unsigned char>(s[i])) << 16
+				| static_cast<uint32_t>(static_cast<unsigned char>(s[i + 1])) << 8
+				| static_cast<uint32_t>(static_cast<unsigned char>(s[i + 2]));
+		}
+
+		void sync(const CommandHistory& history) {
+			if (history.generation() != generation) {
+				postings.clear();
+				indexed = 0;
+				generation = history.generation();
+			}
+			std::vector<uint32_t> keys;
+			for (; indexed < history.size(); ++indexed) {
+				std::string_view entry = history[indexed];
+				keys.clear();
+				for (size_t i = 0; i + 3 <= entry.size(); ++i) keys.push_back(trigram(entry, i));
+				std::sort(keys.begin(), keys.end());
+				keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+				for (uint32_t key : keys) postings[key].push_back(static_cast<uint32_t>(indexed));
+			}
+		}
+	};
+
+	static HistoryIndex historySearch;
+
+	// -------------------------------------------------------------------------
+	// Keystroke Latency Microbenchmark (tcli bench)
+	// -------------------------------------------------------------------------
+
+	bool cmdBench(const std::string&) {
+		static const std::string sample =
+			"connect global https://example.com/a/b?q=1 ld global /var/www/html \"quoted arg\" "
+			"--recursive 0x1F 192.168.0.1 admin@example.com set user true ";
+		const int keystrokes = 2000;
+		std::cout << COLOR_BOLD << COLOR_CYAN << "Input highlighting latency per keystroke" << COLOR_RESET
+				  << COLOR_GRAY << " (" << keystrokes << " keystrokes per line length)\n" << COLOR_RESET;
+		auto report = [](const char* label, std::vector<double>& samples) {
+			std::sort(samples.begin(), samples.end());
+			double mean = 0;
+			for (double v : samples) mean += v;
+			mean /= samples.size();
+			std::cout << "    " << label << "  mean " << COLOR_GREEN << mean << "us" << COLOR_RESET
+					  << "  p50 " << samples[samples.size() / 2] << "us"
+					  << "  p99 " << samples[samples.size() * 99 / 100] << "us\n";
+		};
+		size_t sink = 0;
+		for (size_t length : {80, 512, 2048, 8192, 32768}) {
+			std::string buffer;
+			while (buffer.size() < length) buffer += sample;
+			buffer.resize(length);
+			std::vector<double> full, incremental;
+			full.reserve(keystrokes);
+			incremental.reserve(keystrokes);
+			LineHighlighter hl;
+			hl.reset(buffer);
+			FrameRenderer screen;
+			screen.reset();
+			screen.compose(hl, buffer, {0, 0, 0}, hl.width());
+			for (int i = 0; i < keystrokes; ++i) {
+				// Alternate insert/backspace at the end so the length stays put.
+				size_t at = buffer.size() - (i % 2);
+				if (i % 2 == 0) buffer.push_back(sample[i % sample.size()]);
+				else buffer.pop_back();
+				auto t0 = std::chrono::steady_clock::now();
+				sink += highlightInput(buffer).size();
+				auto t1 = std::chrono::steady_clock::now();
+				auto damage = i % 2 == 0 ? hl.update(buffer, at, 0, 1, false) : hl.update(buffer, at, 1, 0, false);
+				sink += screen.compose(hl, buffer, damage, hl.width()).size();
+				auto t2 = std::chrono::steady_clock::now();
+				full.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+				incremental.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+			}
+			std::cout << "  " << COLOR_YELLOW << std::to_string(length) << " chars" << COLOR_RESET << "\n";
+			report("full        ", full);
+			report("incremental ", incremental);
+		}
+
+		// Reverse search over a large synthetic history, one lookup per typed character.
+		const size_t entries = 200000;
+		static const char* const verbs[] = {"ld local", "ld global", "connect global", "enum", "scan", "set user"};
+		CommandHistory history;
+		for (size_t i = 0; i < entries; ++i)
+			history.push(std::string(verbs[i % 6]) + " https://host" + std::to_string(i * 7919 % 10007) + ".example.com/p/" + std::to_string(i));
+		HistoryIndex index;
+		auto t0 = std::chrono::steady_clock::now();
+		sink += index.findBefore(history, "enum https", history.size());
+		auto t1 = std::chrono::steady_clock::now();
+		std::vector<double> lookups;
+		for (std::string_view query : {"host4242.exa", "global https://host9", "/p/12345", "scan https"}) {
+			for (size_t n = 1; n <= query.size(); ++n) {
+				auto s0 = std::chrono::steady_clock::now();
+				sink += index.findBefore(history, query.substr(0, n), history.size());
+				auto s1 = std::chrono::steady_clock::now();
+				lookups.push_back(std::chrono::duration<double, std::micro>(s1 - s0).count());
+			}
+		}
+		std::cout << "  " << COLOR_YELLOW << "Ctrl-R over " << entries << " entries" << COLOR_RESET << COLOR_GRAY
+				  << " (indexed in " << std::chrono::duration<double, std::milli>(t1 - t0).count() << "ms)\n" << COLOR_RESET;
+		report("search      ", lookups);
+
+		// Fuzzy completion of a slot with a few thousand candidates, one Tab per typed character.
+		const size_t hosts = 5000;
+		static const std::vector<std::string_view> grammar = {"pick <host>"};
+		CompletionEngine engine(grammar);
+		std::vector<std::string> hostNames;
+		for (size_t i = 0; i < hosts; ++i)
+			hostNames.push_back("srv" + std::to_string(i * 7919 % 10007) + ".corp-" + std::to_string(i % 37) + ".example.com");
+		engine.addSource("host", [&](std::string_view, std::vector<std::string_view>& out) {
+			out.insert(out.end(), hostNames.begin(), hostNames.end());
+		});
+		auto u0 = std::chrono::steady_clock::now();
+		sink += engine.complete("pick ", history).total;
+		auto u1 = std::chrono::steady_clock::now();
+		std::vector<double> tabs;
+		for (std::string_view word : {"srv4242", "corp12exm", "s9.c3", "example"}) {
+			for (size_t n = 0; n <= word.size(); ++n) {
+				std::string line = "pick " + std::string(word.substr(0, n));
+				auto c0 = std::chrono::steady_clock::now();
+				sink += engine.complete(line, history).total;
+				auto c1 = std::chrono::steady_clock::now();
+				tabs.push_back(std::chrono::duration<double, std::micro>(c1 - c0).count());
+			}
+		}
+		std::cout << "  " << COLOR_YELLOW << "Tab over " << hosts << " candidates" << COLOR_RESET << COLOR_GRAY
+				  << " (history usage counted in " << std::chrono::duration<double, std::milli>(u1 - u0).count() << "ms)\n" << COLOR_RESET;
+		report("complete    ", tabs);
+		if (sink == 0) std::cout << "\n";
+		return true;
+	}
+
+	// -------------------------------------------------------------------------
+	// Enhanced ReadLine With Tab Completion
+	// -------------------------------------------------------------------------
+
+	/**
+	 * Input line being edited at the prompt. Every edit goes through this class
+	 * so the highlighter only re-lexes around it and the renderer only repaints
+	 * and diffs the cells from the first changed one onwards.
+	 */
+	class LineEditor {
+	public:
+		LineEditor() { screen.reset(); }
+
+		const std::string& text() const { return buffer; }
+		size_t cursorPos() const { return cursor; }
+
+		void insert(std::string_view str) {
+			if (str.empty()) return;
+			buffer.insert(cursor, str);
+			auto damage = hl.update(buffer, cursor, 0, str.size(), hasQuote(str));
+			cursor += str.size();
+			redraw(damage);
+		}
+
+		void erase(size_t at, size_t count) {
+			if (count == 0) return;
+			bool quote = hasQuote(std::string_view(buffer).substr(at, count));
+			buffer.erase(at, count);
+			auto damage = hl.update(buffer, at, count, 0, quote);
+			if (cursor > at) cursor = cursor >= at + count ? cursor - count : at;
+			redraw(damage);
+		}
+
+		/// Replaces the whole line (history navigation) and puts the cursor at its end.
+		void assign(std::string_view str) {
+			buffer = str;
+			cursor = buffer.size();
+			hl.reset(buffer);
+			redraw({0, 0, 0});
+		}
+
+		void moveCursor(size_t pos) {
+			cursor = std::min(pos, buffer.size());
+			screen.placeCursor(hl.columnOf(cursor));
+		}
+
+		/// Moves the terminal cursor past the input without moving the edit cursor.
+		void moveToEnd() {
+			screen.placeCursor(hl.width());
+		}
+
+		/// Draws the whole line again after something else was printed below the prompt.
+		void repaint() {
+			screen.reset();
+			redraw({0, 0, 0});
+		}
+
+		/// Leaves the cursor on a fresh line below the input.
+		void finish() {
+			screen.finish();
+		}
+
+		/// Draws the reverse-search prompt in place of the line, the match in the usual colors.
+		void showSearch(std::string_view query, std::string_view match, bool failed) {
+			std::string_view label = failed ? "(failed reverse-i-search)`" : "(reverse-i-search)`";
+			bool color = colorEnabled();
+			std::string_view frame = color ? COLOR_GRAY : "", typed = color ? COLOR_YELLOW : "";
+			screen.drawWith([&](auto&& emit) {
+				emit(label, frame);
+				emit(query, typed);
+				emit("': ", frame);
+				for (const auto& tok : lexInput(match)) {
+					TokenStyle ts = styleOf(match, tok);
+					emit(ts.label.empty() ? match.substr(tok.begin, tok.length) : ts.label, ts.style);
+				}
+			}, label.size() + query.size());
 		}
-		enumerateDirectories(config["gl_path"]);
-	}
 
-	void removeHistoryFor(const std::string& type, const std::string& path) {
-		auto sanitize = [](const std::string& s) -> std::string {
-			std::string out = s;
-			std::replace(out.begin(), out.end(), '/', '_');
-			std::replace(out.begin(), out.end(), '\\', '_');
-			std::replace(out.begin(), out.end(), ':', '_');
-			std::replace(out.begin(), out.end(), '?', '_');
-			std::replace(out.begin(), out.end(), '*', '_');
-			std::replace(out.begin(), out.end(), '<', '_');
-			std::replace(out.begin(), out.end(), '>', '_');
-			std::replace(out.begin(), out.end(), '|', '_');
-			return out;
-		};
-		std::string histFile = ".tcli_history_" + type + "_" + sanitize(path);
-		if (fs::exists(histFile)) {
-			std::error_code ec;
-			fs::remove(histFile, ec);
-			if (!ec)
-				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Removed history file: " << histFile << "\n";
-			else
-				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Could not remove history file: " << histFile << "\n";
+	private:
+		std::string buffer;
+		size_t cursor = 0;
+		LineHighlighter hl;
+		FrameRenderer screen;
+
+		static bool hasQuote(std::string_view str) {
+			return str.find_first_of("\"'") != std::string_view::npos;
 		}
-	}
 
-	void cmdBreak(const std::string& args) {
-		std::string arg = args;
-		std::transform(arg.begin(), arg.end(), arg.begin(), ::tolower);
-		if (arg == "local") {
-			if (config["lc_path"] == "n/a") {
-				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No local directory is currently connected.\n";
-				return;
+		void redraw(const LineHighlighter::Damage& damage) {
+			screen.draw(hl, buffer, damage, hl.columnOf(cursor));
+		}
+	};
+
+	/// Collects a bracketed paste up to ESC[201~; line breaks and tabs become spaces.
+	std::string readBracketedPaste() {
+		static const std::string_view terminator = "\033[201~";
+		std::string paste;
+		size_t matched = 0;
+		for (int c; matched < terminator.size() && (c = platform::getch()) != EOF; ) {
+			if (static_cast<char>(c) == terminator[matched]) {
+				++matched;
+				continue;
 			}
-			removeHistoryFor("local", config["lc_path"]);
-			config["lc_path"] = "n/a";
-			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Local directory link broken and history removed.\n";
-		} else if (arg == "global") {
-			if (config["gl_path"] == "n/a") {
-				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No global URL is currently connected.\n";
-				return;
+			if (matched) {
+				paste.append(terminator.substr(0, matched));
+				matched = static_cast<char>(c) == terminator[0] ? 1 : 0;
+				if (matched) continue;
 			}
-			removeHistoryFor("global", config["gl_path"]);
-			config["gl_path"] = "n/a";
-			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Global URL link broken and history removed.\n";
-		} else {
-			std::cerr << COLOR_GRAY << "Usage: break local|global" << COLOR_RESET << "\n";
+			if (c == '\n' || c == '\r' || c == '\t') paste += ' ';
+			else if (isprint(c)) paste += static_cast<char>(c);
 		}
+		paste.erase(std::remove_if(paste.begin(), paste.end(), [](char ch) { return !isprint(static_cast<unsigned char>(ch)); }), paste.end());
+		return paste;
 	}
 
-	std::string highlightInput(const std::string& buffer) {
-		static const std::set<std::string> commands = {
-			"quit", "exit", "clr", "clear", "rl", "reload", "connect", "ld", "help", "enum", "break",
-			"scan", "inject", "auth_bypass", "spoof", "session", "history", "payload_gen", "config", "set", "tcli"
-		};
-		static const std::set<std::string> options = {
-			"-h", "--help", "-v", "--version", "-a", "--all", "-r", "--recursive",
-			"--sql", "--xss", "--cmd", "--randomize", "setup"
-		};
-		static const std::set<std::string> keywords = {
-			"local", "global", "user", "admin", "path", "url", "mac", "ip", "dns", "user-agent", "list", "kill", "resume", "show", "set", "clear", "reverse_shell", "keylogger"
+	/**
+	 * Runs a Ctrl-R session on `line`: typing narrows the query, Ctrl-R steps to
+	 * older matches, Backspace widens the query again, Escape or an arrow key
+	 * keeps the match for editing and Ctrl-G restores the original line.
+	 * Returns true when Enter accepted the line for execution.
+	 */
+	bool reverseSearch(LineEditor& line, const CommandHistory& history) {
+		const std::string original = line.text();
+		std::string query;
+		size_t match = HistoryIndex::npos;
+		bool failed = false;
+		auto show = [&] {
+			line.showSearch(query, match == HistoryIndex::npos ? std::string_view() : history[match], failed);
 		};
-		static const std::set<std::string> bool_literals = {
-			"true", "false"
+		auto searchFrom = [&](size_t before) {
+			size_t found = historySearch.findBefore(history, query, before);
+			failed = found == HistoryIndex::npos && !query.empty();
+			if (!failed) match = found;
 		};
-		std::string result;
-		static const std::regex url_regex(R"(https?://[^\s]+)");
-		static const std::regex path_regex(R"((/[^ ]+)+)");
-		static const std::regex number_regex(R"(\b\d+\b)");
-		static const std::regex string_regex(R"(["'][^"']*["'])");
-		static const std::regex flag_regex(R"((--?[a-zA-Z0-9_-]+))");
-		static const std::regex word_regex(R"(\b[a-zA-Z_][a-zA-Z0-9_]*\b)");
-		static const std::regex hex_regex(R"(\b0x[0-9a-fA-F]+\b)");
-		static const std::regex ip_regex(R"(\b\d{1,3}(\.\d{1,3}){3}\b)");
-		static const std::regex email_regex(R"([a-zA-Z0-9_.+-]+@[a-zA-Z0-9-]+\.[a-zA-Z0-9-.]+)");
-		static const std::regex assign_regex(R"((=))");
-		size_t pos = 0;
-		while (pos < buffer.size()) {
-			std::smatch m;
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, url_regex) && m.position() == 0) {
-				result += COLOR_UNDER + COLOR_CYAN + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, path_regex) && m.position() == 0) {
-				result += COLOR_BOLD + COLOR_YELLOW + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, string_regex) && m.position() == 0) {
-				result += COLOR_BG_BLU + COLOR_YELLOW + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, flag_regex) && m.position() == 0) {
-				result += COLOR_BG_YEL + COLOR_BLUE + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, number_regex) && m.position() == 0) {
-				result += COLOR_GREEN + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, hex_regex) && m.position() == 0) {
-				result += COLOR_ORANGE + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, ip_regex) && m.position() == 0) {
-				result += COLOR_BG_CYAN + COLOR_BOLD + COLOR_GRAY + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, email_regex) && m.position() == 0) {
-				result += COLOR_PINK + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, assign_regex) && m.position() == 0) {
-				result += COLOR_BOLD + COLOR_RED + m.str(0) + COLOR_RESET;
-				pos += m.length(0);
-				continue;
-			}
-			if (std::regex_search(buffer.begin() + pos, buffer.end(), m, word_regex) && m.position() == 0) {
-				std::string word = m.str(0);
-				if (commands.count(word)) {
-					result += COLOR_BOLD + COLOR_PURPLE + word + COLOR_RESET;
-				} else if (options.count(word)) {
-					result += COLOR_BG_YEL + COLOR_BLUE + word + COLOR_RESET;
-				} else if (keywords.count(word)) {
-					if (word == "local")
-						result += COLOR_BG_GRN + COLOR_GRAY + " LOCAL " + COLOR_RESET;
-					else if (word == "global")
-						result += COLOR_BG_CYAN + COLOR_GRAY + " GLOBAL " + COLOR_RESET;
-					else if (word == "user")
-						result += COLOR_BG_MAG + COLOR_GRAY + " USER " + COLOR_RESET;
-					else if (word == "admin")
-						result += COLOR_BG_RED + COLOR_BOLD + COLOR_GRAY + " ADMIN " + COLOR_RESET;
-					else if (word == "path")
-						result += COLOR_BOLD + COLOR_YELLOW + word + COLOR_RESET;
-					else if (word == "url")
-						result += COLOR_BOLD + COLOR_CYAN + word + COLOR_RESET;
-					else if (word == "mac")
-						result += COLOR_BOLD + COLOR_PINK + "mac" + COLOR_RESET;
-					else if (word == "ip")
-						result += COLOR_BOLD + COLOR_CYAN + "ip" + COLOR_RESET;
-					else if (word == "dns")
-						result += COLOR_BOLD + COLOR_BLUE + "dns" + COLOR_RESET;
-					else if (word == "user-agent")
-						result += COLOR_BOLD + COLOR_GREEN + "user-agent" + COLOR_RESET;
-					else
-						result += COLOR_BOLD + COLOR_PINK + word + COLOR_RESET;
-				} else if (bool_literals.count(word)) {
-					// Highlight true/false as bold green/red
-					if (word == "true")
-						result += COLOR_BOLD + COLOR_GREEN + word + COLOR_RESET;
-					else
-						result += COLOR_BOLD + COLOR_RED + word + COLOR_RESET;
-				} else {
-					result += word;
+		auto accept = [&] { line.assign(match == HistoryIndex::npos ? std::string_view(original) : history[match]); };
+		show();
+		while (true) {
+			int c = platform::getch();
+			if (c == 10 || c == 13 || c == EOF) {
+				accept();
+				return true;
+			} else if (c == 18) { // Ctrl-R: next older match with different text
+				if (!query.empty() && match != HistoryIndex::npos) {
+					size_t from = match;
+					size_t found;
+					while ((found = historySearch.findBefore(history, query, from)) != HistoryIndex::npos && history[found] == history[match])
+						from = found;
+					failed = found == HistoryIndex::npos;
+					if (!failed) match = found;
 				}
-				pos += m.length(0);
-				continue;
+			} else if (c == 127 || c == 8) {
+				if (!query.empty()) query.pop_back();
+				match = HistoryIndex::npos;
+				searchFrom(history.size());
+			} else if (c == 7 || c == 3) { // Ctrl-G / Ctrl-C: abort
+				line.assign(original);
+				return false;
+			} else if (c == 27) { // Escape (or an arrow key): keep the match for editing
+				if (platform::peekch() == '[') {
+					platform::getch();
+					platform::getch();
+				}
+				accept();
+				return false;
+			} else if (isprint(c)) {
+				query += static_cast<char>(c);
+				searchFrom(match == HistoryIndex::npos ? history.size() : match + 1);
+			} else {
+				accept();
+				return false;
 			}
-			result += buffer[pos];
-			++pos;
+			show();
 		}
-		return result;
 	}
 
-	// -------------------------------------------------------------------------
-	// Enhanced ReadLine With Tab Completion
-	// -------------------------------------------------------------------------
-	std::string readLineWithArrows(std::vector<std::string>& history) {
-		std::string buffer;
-		size_t cursor = 0;
+	std::string readLineWithArrows(const CommandHistory& history) {
+		platform::TerminalSession terminal;
+		LineEditor line;
 		int historyIndex = history.size();
 		std::string currentBuffer;
 		bool inHistory = false;
 		bool promptPrinted = false;
 		while (true) {
 			int c = platform::getch();
-			if (!promptPrinted && (isprint(c) || c == 27 || c == 127 || c == 8 || c == 9)) {
+			if (c == EOF) { // Input closed: run what was typed, then shut down
+				shouldClose = true;
+				if (promptPrinted) line.finish();
+				break;
+			}
+			if (!promptPrinted && (isprint(c) || c == 27 || c == 127 || c == 8 || c == 9 || c == 10 || c == 13 || c == 18)) {
 				std::cout << "\n";
 				printPrompt();
 				std::cout.flush();
-				std::cout << "\033[s";
 				promptPrinted = true;
 			}
 			if (c == 10 || c == 13) { // Enter
-				if (!promptPrinted) {
-					std::cout << "\n";
-					printPrompt();
-					std::cout.flush();
-					std::cout << "\033[s";
-					promptPrinted = true;
-				}
-				std::cout << "\033[u";
-				std::cout << highlightInput(buffer);
-				std::cout << "\033[K" << std::endl;
+				line.finish();
 				break;
-			} else if (c == 127 || c == 8) { // Backspace
-				if (cursor > 0) {
-					buffer.erase(buffer.begin() + cursor - 1);
-					cursor--;
-					std::cout << "\033[u";
-					std::cout << highlightInput(buffer);
-					std::cout << "\033[K";
-					for (size_t i = 0; i < buffer.size() - cursor; ++i) std::cout << "\b";
-					std::cout.flush();
+			} else if (c == 3) { // Ctrl-C: abandon the line
+				if (promptPrinted) {
+					line.finish();
+					return "";
 				}
+			} else if (c == 127 || c == 8) { // Backspace
+				if (line.cursorPos() > 0)
+					line.erase(line.cursorPos() - 1, 1);
 			} else if (c == 27) { // Escape sequence
 				int c1 = platform::getch();
 				if (c1 == 91) {
 					int c2 = platform::getch();
 					if (c2 == 68) { // Left arrow
-						if (cursor > 0) {
-							cursor--;
-							std::cout << "\b";
-						}
+						if (line.cursorPos() > 0) line.moveCursor(line.cursorPos() - 1);
 					} else if (c2 == 67) { // Right arrow
-						if (cursor < buffer.size()) {
-							std::cout << buffer[cursor];
-							cursor++;
-						}
+						line.moveCursor(line.cursorPos() + 1);
 					} else if (c2 == 65) { // Up arrow
 						if (historyIndex > 0) {
 							if (!inHistory) {
-								currentBuffer = buffer;
+								currentBuffer = line.text();
 								inHistory = true;
 							}
 							historyIndex--;
-							buffer = history[historyIndex];
-							cursor = buffer.size();
-							std::cout << "\033[u";
-							std::cout << highlightInput(buffer);
-							std::cout << "\033[K";
-							std::cout.flush();
+							line.assign(history[historyIndex]);
 						}
 					} else if (c2 == 66) { // Down arrow
 						if (inHistory && historyIndex < (int)history.size() - 1) {
 							historyIndex++;
-							buffer = history[historyIndex];
-							cursor = buffer.size();
-							std::cout << "\033[u";
-							std::cout << highlightInput(buffer);
-							std::cout << "\033[K";
-							std::cout.flush();
+							line.assign(history[historyIndex]);
 						} else if (inHistory && historyIndex == (int)history.size() - 1) {
 							historyIndex++;
-							buffer = currentBuffer;
-							cursor = buffer.size();
-							std::cout << "\033[u";
-							std::cout << highlightInput(buffer);
-							std::cout << "\033[K";
-							std::cout.flush();
+							line.assign(currentBuffer);
 							inHistory = false;
 						}
+					} else if (isAsciiDigit(static_cast<char>(c2))) { // ESC [ <n> ~
+						int code = c2 - '0';
+						int d;
+						while ((d = platform::getch()) != EOF && isAsciiDigit(static_cast<char>(d)))
+							code = code * 10 + (d - '0');
+						if (code == 200) line.insert(readBracketedPaste());
 					}
 				}
-				else if (c == 9) { // Tab
-					std::string prefix = buffer.substr(0, cursor);
-					std::vector<std::string> completions = getCompletions(prefix);
-					if (completions.empty()) {
-						// No completions, beep
-						std::cout << "\a";
-						std::cout.flush();
-					} else if (completions.size() == 1) {
-						// Single completion: complete it
-						std::string comp = completions[0];
-						// Find the last token in prefix
-						size_t lastSpace = prefix.find_last_of(" ");
-						std::string before = (lastSpace == std::string::npos) ? "" : prefix.substr(0, lastSpace + 1);
-						std::string token = (lastSpace == std::string::npos) ? prefix : prefix.substr(lastSpace + 1);
-						std::string toInsert = comp.substr(token.size());
-						buffer.insert(cursor, toInsert);
-						cursor += toInsert.size();
-						std::cout << "\033[u";
-						std::cout << highlightInput(buffer);
-						std::cout << "\033[K";
-						for (size_t i = 0; i < buffer.size() - cursor; ++i) std::cout << "\b";
-						std::cout.flush();
-					} else {
-						// Multiple completions: find common prefix
-						size_t lastSpace = prefix.find_last_of(" ");
-						std::string token = (lastSpace == std::string::npos) ? prefix : prefix.substr(lastSpace + 1);
-						std::string common = completions[0];
-						for (const auto& s : completions) {
-							size_t j = token.size();
-							while (j < common.size() && j < s.size() && common[j] == s[j]) ++j;
-							common = common.substr(0, j);
-						}
-						if (common.size() > token.size()) {
-							std::string toInsert = common.substr(token.size());
-							buffer.insert(cursor, toInsert);
-							cursor += toInsert.size();
-							std::cout << "\033[u";
-							std::cout << highlightInput(buffer);
-							std::cout << "\033[K";
-							for (size_t i = 0; i < buffer.size() - cursor; ++i) std::cout << "\b";
-							std::cout.flush();
-						} else {
-							// Print completions and reprint prompt+buffer
-							printCompletions(completions);
-							std::cout << "\033[u";
-							std::cout << highlightInput(buffer);
-							std::cout << "\033[K";
-							for (size_t i = 0; i < buffer.size() - cursor; ++i) std::cout << "\b";
-							std::cout.flush();
-						}
-					}
+			} else if (c == 18) { // Ctrl-R
+				if (reverseSearch(line, history)) {
+					line.finish();
+					break;
 				}
-				} else if (isprint(c)) {
-					buffer.insert(buffer.begin() + cursor, (char)c);
-					cursor++;
-					std::cout << "\033[u";
-					std::cout << highlightInput(buffer);
-					std::cout << "\033[K";
-					for (size_t i = 0; i < buffer.size() - cursor; ++i) std::cout << "\b";
+			} else if (c == 9) { // Tab
+				std::string_view prefix = std::string_view(line.text()).substr(0, line.cursorPos());
+				auto completion = completionEngine().complete(prefix, history);
+				size_t typed = prefix.size() - completion.wordBegin;
+				if (completion.total == 0) {
+					// No completions, beep
+					std::cout << "\a";
 					std::cout.flush();
+				} else if (completion.total == 1) {
+					// Single completion: replace the word with it
+					line.erase(completion.wordBegin, typed);
+					line.insert(completion.matches[0]);
+				} else if (completion.common.size() > typed) {
+					// Multiple completions sharing a longer prefix: extend it
+					line.insert(std::string_view(completion.common).substr(typed));
+				} else {
+					// Print completions best first and reprint prompt+buffer
+					line.moveToEnd();
+					printCompletions(completion.matches, completion.total);
+					line.repaint();
 				}
+			} else if (isprint(c)) {
+				// Take every printable byte that is already waiting (a paste without
+				// bracketed paste support) and apply them as one edit.
+				std::string burst(1, static_cast<char>(c));
+				for (int next; (next = platform::peekch()) != EOF && isprint(next); )
+					burst += static_cast<char>(platform::getch());
+				line.insert(burst);
 			}
-		return buffer;
+		}
+		return line.text();
 	}
 
-	void cmdScan(const std::string& args) {
+	bool cmdScan(const std::string& args) {
 		std::string target = args;
 		if (target.empty()) {
 			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: scan [target]\n";
-			return;
+			return false;
 		}
-		std::cout << COLOR_CYAN << "Scanning " << target << " for open ports/services...\n" << COLOR_RESET;
+		if (!piped()) std::cout << COLOR_CYAN << "Scanning " << target << " for open ports/services...\n" << COLOR_RESET;
 
 		if (fs::exists(target) && fs::is_directory(target)) {
+			if (piped()) return true;
 			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Local directory detected. Simulating service scan...\n";
 			std::vector<std::string> services = {"ssh", "http", "ftp", "smb"};
 			for (const auto& svc : services) {
 				std::cout << "  - " << COLOR_BLUE << svc << COLOR_RESET << " : " << COLOR_GREEN << "running" << COLOR_RESET << "\n";
 			}
-			return;
+			return true;
 		}
 
 		std::vector<int> ports = {21, 22, 23, 25, 53, 80, 110, 143, 443, 3306, 8080};
@@ -1062,33 +4368,34 @@ namespace CLI {
 			"FTP", "SSH", "Telnet", "SMTP", "DNS", "HTTP", "POP3", "IMAP", "HTTPS", "MySQL", "HTTP-alt"
 		};
 		std::vector<std::future<void>> futures;
-		std::mutex outMutex;
-		std::string timeout = config["scan_timeout"];
 		for (size_t i = 0; i < ports.size(); ++i) {
-			futures.push_back(std::async(std::launch::async, [&, i] {
-				std::string cmd = "timeout " + timeout + " bash -c \"</dev/tcp/" + target + "/" + std::to_string(ports[i]) + "\" 2>/dev/null && echo open || echo closed";
-				FILE* pipe = popen(cmd.c_str(), "r");
-				if (!pipe) return;
-				char buf[32];
-				std::string res;
-				while (fgets(buf, sizeof(buf), pipe)) res += buf;
-				pclose(pipe);
-				std::lock_guard<std::mutex> lock(outMutex);
-				if (res.find("open") != std::string::npos)
-					std::cout << "  - Port " << COLOR_YELLOW << ports[i] << COLOR_RESET << " (" << portNames[i] << "): " << COLOR_GREEN << "open" << COLOR_RESET << "\n";
+			futures.push_back(runTask([&, i] {
+				if (!checkpoint()) return;
+				std::string cmd = "timeout " + liveSettings()->scanTimeout + " bash -c \"</dev/tcp/" + target + "/" + std::to_string(ports[i]) + "\" 2>/dev/null && echo open || echo closed";
+				std::string res = runTracked(cmd);
+				if (jobCancelled() || res.find("open") == std::string::npos) return;
+				std::string url = "tcp://" + target + ":" + std::to_string(ports[i]);
+				resultStore.add(url, 0, ResultStore::unknownSize, ResultStore::Port, ResultStore::Scan);
+				if (emitRecord(std::move(url), 0, false)) return;
+				terminalWriter.push(concat("  - Port ", COLOR_YELLOW, std::to_string(ports[i]), COLOR_RESET, " (", portNames[i], "): ", COLOR_GREEN, "open", COLOR_RESET, "\n"));
 			}));
 		}
 		for (auto& f : futures) f.wait();
-		std::cout << COLOR_CYAN << "Scan complete.\n" << COLOR_RESET;
+		if (jobCancelled()) {
+			reportCancelled("Scan");
+			return true;
+		}
+		if (!piped()) std::cout << COLOR_CYAN << "Scan complete.\n" << COLOR_RESET;
+		return true;
 	}
 
-	void cmdInject(const std::string& args) {
+	bool cmdInject(const std::string& args) {
 		std::istringstream iss(args);
 		std::string target, payload, mode;
 		iss >> target >> payload >> mode;
 		if (target.empty() || payload.empty() || mode.empty()) {
 			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: inject [target] [payload] [--sql|--xss|--cmd]\n";
-			return;
+			return false;
 		}
 		std::cout << COLOR_CYAN << "Simulating injection on " << target << " with payload: " << payload << "\n" << COLOR_RESET;
 		if (mode == "--sql") {
@@ -1102,14 +4409,16 @@ namespace CLI {
 			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " No command executed (simulation).\n";
 		} else {
 			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Unknown mode. Use --sql, --xss, or --cmd\n";
+			return false;
 		}
+		return true;
 	}
 
-	void cmdAuthBypass(const std::string& args) {
+	bool cmdAuthBypass(const std::string& args) {
 		std::string target = args;
 		if (target.empty()) {
 			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: auth_bypass [target]\n";
-			return;
+			return false;
 		}
 		std::cout << COLOR_CYAN << "Testing authentication bypass on " << target << "...\n" << COLOR_RESET;
 		std::vector<std::pair<std::string, std::string>> creds = {
@@ -1120,15 +4429,16 @@ namespace CLI {
 			std::cout << COLOR_RED << "fail" << COLOR_RESET << "\n";
 		}
 		std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " No weak authentication found (simulation).\n";
+		return true;
 	}
 
-	void cmdSpoof(const std::string& args) {
+	bool cmdSpoof(const std::string& args) {
 		std::istringstream iss(args);
 		std::string type, option;
 		iss >> type >> option;
 		if (type.empty()) {
 			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: spoof [mac|ip|dns|user-agent] [options]\n";
-			return;
+			return false;
 		}
 		if (type == "mac") {
 			if (option == "--randomize") {
@@ -1168,10 +4478,108 @@ namespace CLI {
 			std::cout << COLOR_CYAN << "Spoofed User-Agent: " << ua << COLOR_RESET << "\n";
 		} else {
 			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Unknown spoof type. Use mac, ip, dns, or user-agent\n";
+			return false;
+		}
+		return true;
+	}
+
+	/// Prints a session's captured output that has not been shown yet.
+	void showSessionOutput(Session& session) {
+		if (!session.job) return;
+		std::string unread;
+		{
+			// Printing waits for the TerminalWriter, which may need this lock to store the job's next block.
+			std::lock_guard<std::mutex> lock(session.job->outputMutex);
+			unread = session.job->output.substr(session.job->shown);
+			session.job->shown = session.job->output.size();
+		}
+		std::cout << unread;
+	}
+
+	/// Continues a crawl loaded from a snapshot from its frontier, reusing what it already found.
+	void continueWork() {
+		WorkState& state = workState();
+		std::vector<std::pair<std::string, WorkState::Pending>> pending;
+		{
+			std::lock_guard<std::mutex> lock(state.mutex);
+			std::cout << COLOR_CYAN << "Findings so far (" << state.findings.size() << "):\n" << COLOR_RESET;
+			std::string out;
+			for (const auto& [url, finding] : state.findings) appendRecordLine(out, url, finding.status, finding.directory, finding.target);
+			std::cout << out;
+			pending.assign(state.frontier.begin(), state.frontier.end());
+		}
+		std::map<std::string, std::shared_ptr<const std::string>> targets;
+		for (const auto& item : pending)
+			if (!item.second.target.empty() && !targets.count(item.second.target))
+				targets[item.second.target] = std::make_shared<const std::string>(item.second.target);
+		std::atomic<size_t> next{0};
+		size_t workers = std::min<size_t>(pending.size(), settings().maxRequests);
+		std::vector<std::future<void>> futures;
+		for (size_t i = 0; i < workers; ++i) {
+			futures.push_back(runTask([&] {
+				for (size_t n; (n = next++) < pending.size() && checkpoint();) {
+					const auto& [url, item] = pending[n];
+					currentTarget = item.target.empty() ? nullptr : targets[item.target];
+					if (state.kind == WorkState::Kind::Enum) enumerateDirectories(url, item.depth);
+					else listGlobalRecursive(url, item.depth);
+				}
+				currentTarget.reset();
+			}));
+		}
+		for (auto& f : futures) f.wait();
+		if (jobCancelled()) reportCancelled("Resumed crawl");
+		else std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Resumed crawl finished.\n";
+	}
+
+	/// Loads session `id`'s snapshot and continues its crawl as a background job.
+	bool resumeSnapshot(int id, const std::string& path) {
+		auto job = std::make_shared<Job>();
+		std::vector<std::pair<std::string, std::string>> overrides;
+		if (!loadSnapshot(path, job->state, overrides)) {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Snapshot " << path << " is missing or damaged.\n";
+			return false;
+		}
+		// Saved options apply to this session only; the prompt and other jobs keep theirs.
+		std::shared_ptr<const Settings> restored = deriveSettings(overrides), live = liveSettings();
+		for (const auto& [key, value] : overrides) {
+			auto current = live->values.find(key);
+			if (current == live->values.end() || current->second == value || !checkOption(key, value).empty()) continue;
+			if (isLiveOption(key))
+				std::cout << COLOR_YELLOW << "[ INFO ]" << COLOR_RESET << " Saved " << key << " = " << value
+					<< " not restored; the current " << current->second << " applies to all jobs.\n";
+			else
+				std::cout << COLOR_YELLOW << "[ INFO ]" << COLOR_RESET << " Session " << id << " uses its saved " << key << " = " << value << "\n";
+		}
+		size_t pending = job->state.frontier.size(), visited = job->state.visited.size(), findings = job->state.findings.size();
+		std::string command = job->state.command;
+		auto it = std::find_if(sessions.begin(), sessions.end(), [id](const Session& s){ return s.id == id; });
+		if (it == sessions.end()) it = sessions.insert(sessions.end(), {id, command.substr(0, command.find(' ')), command, true, nullptr});
+		it->job = job;
+		it->active = true;
+		it->snapshot.clear();
+		launchJob(job, id, continueWork, std::move(restored));
+		std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Session " << id << " resumed from its snapshot: "
+			<< pending << " URL(s) to go, " << visited << " done, " << findings << " finding(s) kept.\n";
+		return true;
+	}
+
+	/// Lists snapshots left in `session_dir` by earlier runs as resumable sessions.
+	void loadSavedSessions() {
+		std::error_code ec;
+		for (const auto& entry : fs::directory_iterator(config["session_dir"], ec)) {
+			const fs::path& path = entry.path();
+			std::string stem = path.stem().string();
+			if (path.extension() != ".snap" || stem.empty() || !std::all_of(stem.begin(), stem.end(), ::isdigit)) continue;
+			std::string command = snapshotCommand(path.string());
+			if (command.empty()) continue;
+			int id = std::stoi(stem);
+			sessions.push_back({id, command.substr(0, command.find(' ')), command, false, nullptr, path.string()});
+			nextSessionId = std::max(nextSessionId, id + 1);
 		}
+		std::sort(sessions.begin(), sessions.end(), [](const Session& a, const Session& b) { return a.id < b.id; });
 	}
 
-	void cmdSession(const std::string& args) {
+	bool cmdSession(const std::string& args) {
 		std::istringstream iss(args);
 		std::string subcmd;
 		iss >> subcmd;
@@ -1179,62 +4587,124 @@ namespace CLI {
 			std::cout << COLOR_BOLD << COLOR_CYAN << "Active Sessions:\n" << COLOR_RESET;
 			if (sessions.empty()) {
 				std::cout << COLOR_GRAY << "  (No active sessions)\n" << COLOR_RESET;
-				return;
+				return true;
 			}
 			for (const auto& s : sessions) {
+				std::string state = s.active ? concat(COLOR_GREEN, "active") : concat(COLOR_GRAY, "inactive");
+				if (!s.job && !s.snapshot.empty()) state = concat(COLOR_YELLOW, "saved");
+				else if (s.job && s.job->finished && !s.job->snapshot.empty()) state = concat(COLOR_YELLOW, "killed, saved");
+				else if (s.job && s.job->finished) state = concat(COLOR_GRAY, s.job->token.cancelled() ? "killed" : "done");
+				else if (s.job && s.job->token.cancelled()) state = concat(COLOR_YELLOW, "stopping");
+				else if (s.job) state = s.job->token.paused() ? concat(COLOR_YELLOW, "paused") : concat(COLOR_GREEN, "running");
 				std::cout << "  [" << COLOR_YELLOW << s.id << COLOR_RESET << "] "
 					<< COLOR_PURPLE << s.type << COLOR_RESET << " - "
-					<< (s.active ? COLOR_GREEN + std::string("active") : COLOR_GRAY + std::string("inactive")) << COLOR_RESET
-					<< " (" << s.info << ")\n";
+					<< state << COLOR_RESET
+					<< " (" << s.info << ")";
+				if (s.job && !s.job->finished && s.job->weight != 1) std::cout << COLOR_GRAY << " weight " << s.job->weight << COLOR_RESET;
+				if (s.job) {
+					size_t unread;
+					{
+						std::lock_guard<std::mutex> lock(s.job->outputMutex);
+						unread = std::count(s.job->output.begin() + static_cast<std::ptrdiff_t>(s.job->shown), s.job->output.end(), '\n');
+					}
+					if (unread) std::cout << COLOR_GRAY << " " << unread << " new line(s)" << COLOR_RESET;
+				}
+				std::cout << "\n";
 			}
 		} else if (subcmd == "kill") {
-			int id;
+			int id = 0;
 			iss >> id;
 			if (!id) {
 				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: session kill <id>\n";
-				return;
+				return false;
 			}
 			auto it = std::find_if(sessions.begin(), sessions.end(), [id](const Session& s){ return s.id == id; });
-			if (it != sessions.end() && it->active) {
+			if (it != sessions.end() && !it->job && !it->snapshot.empty()) {
+				std::error_code ec;
+				fs::remove(it->snapshot, ec);
+				sessions.erase(it);
+				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Saved state of session " << id << " discarded.\n";
+			} else if (it != sessions.end() && it->active) {
 				it->active = false;
+				if (it->job) it->job->token.cancel();
 				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Session " << id << " terminated.\n";
 			} else {
 				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No active session with ID " << id << ".\n";
+				return false;
 			}
 		} else if (subcmd == "resume") {
-			int id;
+			int id = 0;
 			iss >> id;
 			if (!id) {
 				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: session resume <id>\n";
-				return;
+				return false;
 			}
 			auto it = std::find_if(sessions.begin(), sessions.end(), [id](const Session& s){ return s.id == id; });
-			if (it != sessions.end() && !it->active) {
+			std::string saved = it == sessions.end() ? "" : it->job ? (it->job->finished ? it->job->snapshot : "") : it->snapshot;
+			if (!saved.empty()) {
+				showSessionOutput(*it);
+				return resumeSnapshot(id, saved);
+			} else if (it != sessions.end() && it->job) {
+				it->job->token.resume();
+				showSessionOutput(*it);
+				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Session " << id
+					<< (it->job->finished ? " has finished.\n" : " is still running; resume again for more output.\n");
+			} else if (it != sessions.end() && !it->active) {
 				it->active = true;
 				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Session " << id << " resumed.\n";
 			} else {
 				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No inactive session with ID " << id << ".\n";
+				return false;
+			}
+		} else if (subcmd == "pause") {
+			int id = 0;
+			iss >> id;
+			auto it = std::find_if(sessions.begin(), sessions.end(), [id](const Session& s){ return s.id == id; });
+			if (it != sessions.end() && it->job && !it->job->finished && !it->job->token.cancelled()) {
+				it->job->token.pause();
+				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Session " << id
+					<< " paused; requests in flight finish, no new ones start until `session resume " << id << "`.\n";
+			} else {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No running job with ID " << id << ".\n";
+				return false;
+			}
+		} else if (subcmd == "weight") {
+			int id = 0, weight = 0;
+			iss >> id >> weight;
+			auto it = std::find_if(sessions.begin(), sessions.end(), [id](const Session& s){ return s.id == id; });
+			if (weight < 1 || weight > 100) {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Usage: session weight <id> <1-100>\n";
+				return false;
+			} else if (it != sessions.end() && it->job && !it->job->finished) {
+				it->job->weight = static_cast<uint32_t>(weight);
+				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Session " << id << " now has weight " << weight << ".\n";
+			} else {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " No running job with ID " << id << ".\n";
+				return false;
 			}
 		} else {
 			std::cerr << COLOR_GRAY << "Usage:\n"
 				<< "  session list\n"
 				<< "  session kill <id>\n"
-				<< "  session resume <id>\n" << COLOR_RESET;
+				<< "  session pause <id>\n"
+				<< "  session resume <id>\n"
+				<< "  session weight <id> <1-100>\n" << COLOR_RESET;
+			return false;
 		}
+		return true;
 	}
 
-	void cmdHistory(const std::string& args) {
+	bool cmdHistory(const std::string& args) {
 		std::string subcmd = args;
 		std::transform(subcmd.begin(), subcmd.end(), subcmd.begin(), ::tolower);
 		if (subcmd.empty()) {
 			std::cout << COLOR_BOLD << COLOR_CYAN << "Command History:\n" << COLOR_RESET;
-			if (globalHistory.empty()) {
+			if (commandHistory.empty()) {
 				std::cout << COLOR_GRAY << "  (No history)\n" << COLOR_RESET;
-				return;
+				return true;
 			}
-			int idx = 1;
-			for (const auto& h : globalHistory) {
-				std::cout << "  " << COLOR_YELLOW << idx++ << COLOR_RESET << ": " << h << "\n";
+			for (size_t i = 0; i < commandHistory.size(); ++i) {
+				std::cout << "  " << COLOR_YELLOW << i + 1 << COLOR_RESET << ": " << commandHistory[i] << "\n";
 			}
 		} else if (subcmd == "clear") {
 			std::cout << COLOR_YELLOW << "Are you sure you want to clear all history? (y/n): " << COLOR_RESET;
@@ -1242,17 +4712,19 @@ namespace CLI {
 			std::getline(std::cin, answer);
 			std::transform(answer.begin(), answer.end(), answer.begin(), ::tolower);
 			if (answer == "y" || answer == "yes") {
-				globalHistory.clear();
+				commandHistory.clear();
 				std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " History cleared.\n";
 			} else {
 				std::cout << COLOR_GRAY << "History not cleared.\n" << COLOR_RESET;
 			}
 		} else {
 			std::cerr << COLOR_GRAY << "Usage: history [clear]" << COLOR_RESET << "\n";
+			return false;
 		}
+		return true;
 	}
 
-	void cmdPayloadGen(const std::string& args) {
+	bool cmdPayloadGen(const std::string& args) {
 		std::string type = args;
 		std::transform(type.begin(), type.end(), type.begin(), ::tolower);
 		if (type == "reverse_shell") {
@@ -1268,10 +4740,12 @@ namespace CLI {
 				"with keyboard.Listener(on_press=on_press) as l: l.join()" << COLOR_RESET << "\n";
 		} else {
 			std::cerr << COLOR_GRAY << "Supported types: reverse_shell, keylogger\nUsage: payload_gen <type>" << COLOR_RESET << "\n";
+			return false;
 		}
+		return true;
 	}
 
-	void cmdConfig(const std::string& args) {
+	bool cmdConfig(const std::string& args) {
 		std::istringstream iss(args);
 		std::string subcmd;
 		iss >> subcmd;
@@ -1285,12 +4759,16 @@ namespace CLI {
 			iss >> key >> value;
 			if (key.empty() || value.empty()) {
 				std::cerr << COLOR_GRAY << "Usage: config set <key> <value>" << COLOR_RESET << "\n";
-				return;
+				return false;
 			}
 			std::transform(key.begin(), key.end(), key.begin(), ::tolower);
 			if (config.count(key) == 0) {
 				std::cerr << COLOR_GRAY << "Unknown config key: " << key << COLOR_RESET << "\n";
-				return;
+				return false;
+			}
+			if (std::string error = checkOption(key, value); !error.empty()) {
+				std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " " << error << "\n";
+				return false;
 			}
 			std::cout << COLOR_YELLOW << "Are you sure you want to change '" << key << "' to '" << value << "'? (y/n): " << COLOR_RESET;
 			std::string answer;
@@ -1298,22 +4776,25 @@ namespace CLI {
 			std::transform(answer.begin(), answer.end(), answer.begin(), ::tolower);
 			if (!(answer == "y" || answer == "yes")) {
 				std::cout << COLOR_GRAY << "Config not changed.\n" << COLOR_RESET;
-				return;
+				return true;
 			}
-			config[key] = value;
-			saveConfig("TCLI");
+			setOption(key, value);
+			publishSettings();
+			if (!saveConfig("TCLI")) return false;
 			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Config updated.\n";
 		} else {
 			std::cerr << COLOR_GRAY << "Usage:\n"
 				<< "  config show\n"
 				<< "  config set <key> <value>\n" << COLOR_RESET;
+			return false;
 		}
+		return true;
 	}
 
 	// -------------------------------------------------------------------------
 	// New: Set Command for Realtime/Temporary or Persistent Config Change
 	// -------------------------------------------------------------------------
-	void cmdSet(const std::string& args) {
+	bool cmdSet(const std::string& args) {
 		std::istringstream iss(args);
 		std::string key, value, persist;
 		iss >> key >> std::ws;
@@ -1327,77 +4808,597 @@ namespace CLI {
 		if (key.empty() || value.empty() || persist.empty()) {
 			std::cerr << COLOR_GRAY << "Usage: set <key> <value> <true|false>\n"
 				<< "Example: set user \"init\" true\n" << COLOR_RESET;
-			return;
+			return false;
 		}
 		std::transform(key.begin(), key.end(), key.begin(), ::tolower);
 		std::transform(persist.begin(), persist.end(), persist.begin(), ::tolower);
 		if (config.count(key) == 0) {
 			std::cerr << COLOR_GRAY << "Unknown config key: " << key << COLOR_RESET << "\n";
-			return;
+			return false;
 		}
-		config[key] = value;
+		if (std::string error = setOption(key, value); !error.empty()) {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " " << error << "\n";
+			return false;
+		}
+		publishSettings();
+		if (key == "history_file") commandHistory.open(value);
 		if (persist == "true" || persist == "1" || persist == "yes") {
-			saveConfig("TCLI");
+			if (!saveConfig("TCLI")) return false;
 			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " '" << key << "' set to '" << value << "' (persisted).\n";
 		} else {
 			std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " '" << key << "' set to '" << value << "' (temporary).\n";
 		}
+		return true;
 	}
 
 	// -------------------------------------------------------------------------
 	// Main CLI Loop
 	// -------------------------------------------------------------------------
 
+	// -------------------------------------------------------------------------
+	// Command Table
+	// -------------------------------------------------------------------------
+
+	const CommandRegistry& commandRegistry() {
+		static const CommandRegistry registry({
+			{"help", {"--help", "-h"}, cmdHelp, {}, 0, -1, "help", {},
+				{{"help", "Show this help message"}}},
+			{"quit", {"exit"}, cmdQuit, {}, 0, -1, "quit", {},
+				{{"quit, exit", "Exit the CLI"}}},
+			{"clr", {"clear"}, cmdClear, {}, 0, -1, "clr", {},
+				{{"clr, clear", "Clear the screen"}}},
+			{"rl", {"reload"}, cmdReload, {}, 0, -1, "rl", {},
+				{{"rl, reload", "Reload config and banner"}}},
+			{"tcli", {}, nullptr, {{"setup", cmdSetup}, {"bench", cmdBench}}, 1, 1, "tcli setup|bench",
+				{"setup|bench"},
+				{{"tcli setup", "Create a new config file"},
+				 {"tcli bench", "Measure input highlighting, search and completion latency"}}},
+			{"connect", {}, cmdConnect, {}, 2, -1, "connect local <path> | connect global <url>",
+				{"local <path>", "global http|https <host>", "global <url>"},
+				{{"connect local <path>", "Connect to a local directory"},
+				 {"connect global <url>", "Connect to a global URL"}}},
+			{"ld", {}, nullptr, {{"local", cmdListLocal}, {"global", cmdListGlobal}}, 1, 3, "ld local|global [url|--targets <file>]",
+				{"local", "global <url>", "global --targets <path>"},
+				{{"ld local", "List local directories/files"},
+				 {"ld global [url]", "List global directories/files recursively"},
+				 {"ld global --targets <file>", "List every URL in file, tagged by target"}}, true, true},
+			{"enum", {}, cmdEnum, {}, 0, 2, "enum [url|--targets <file>]",
+				{"<url>", "--targets <path>"},
+				{{"enum [url]", "Enumerate directories on global URL (or the given one)"},
+				 {"enum --targets <file>", "Enumerate every URL in file concurrently, tagged by target"}}, true, true},
+			{"query", {}, cmdQuery, {}, 0, -1, "query <field><op><value> [and ...] [limit <n>]",
+				{},
+				{{"query <conditions>", "Search stored enum/ld/scan results, e.g. status=200 and size>1M and host~corp"},
+				 {"query ... limit <n>", "Show up to n matches (default 100)"}}, false, true},
+			{"break", {}, cmdBreak, {}, 0, -1, "break local|global",
+				{"local|global"},
+				{{"break local|global", "Break link and clear history for local/global"}}},
+			{"scan", {}, cmdScan, {}, 0, -1, "scan [target]",
+				{"<target>"},
+				{{"scan [target]", "Scan local/remote for open ports/services"}}, true, true},
+			{"inject", {}, cmdInject, {}, 0, -1, "inject [target] [payload] [--sql|--xss|--cmd]",
+				{"<target> <payload> --sql|--xss|--cmd"},
+				{{"inject [target] [payload] [--sql|--xss|--cmd]", "Simulate injection attacks"}}, true},
+			{"auth_bypass", {}, cmdAuthBypass, {}, 0, -1, "auth_bypass [target]",
+				{"<target>"},
+				{{"auth_bypass [target]", "Test for insecure authentication"}}, true},
+			{"spoof", {}, cmdSpoof, {}, 0, -1, "spoof [mac|ip|dns|user-agent] [options]",
+				{"mac|ip|dns|user-agent"},
+				{{"spoof [type] [options]", "Spoof mac/ip/dns/user-agent"}}},
+			{"session", {}, cmdSession, {}, 0, -1, "session list|kill <id>|pause <id>|resume <id>|weight <id> <n>",
+				{"list|kill|pause|resume|weight"},
+				{{"session list", "List sessions and background jobs"},
+				 {"session kill <id>", "Terminate session by ID (stops its job)"},
+				 {"session pause <id>", "Stop a job from starting new requests"},
+				 {"session resume <id>", "Resume a paused job or a saved crawl / show a job's new output"},
+				 {"session weight <id> <n>", "Give a job n shares of the request budget (default 1)"},
+				 {"<command> &", "Run enum, ld, scan, inject or auth_bypass in the background"},
+				 {"<command> | <stage>", "Filter enum/ld/scan/query results: match <regex>, status <code>, count"},
+				 {"<command> --output jsonl", "Print enum/ld/scan/query results as JSON lines"}}},
+			{"history", {}, cmdHistory, {}, 0, 1, "history [clear]",
+				{"clear"},
+				{{"history", "Show command history"},
+				 {"history clear", "Clear entire history"}}},
+			{"payload_gen", {}, cmdPayloadGen, {}, 0, -1, "payload_gen <type>",
+				{"reverse_shell|keylogger"},
+				{{"payload_gen <type>", "Generate a custom payload (reverse_shell, keylogger)"}}},
+			{"config", {}, cmdConfig, {}, 0, -1, "config show | config set <key> <value>",
+				{"show", "set <config_key>"},
+				{{"config show", "Display current configuration"},
+				 {"config set <key> <value>", "Change a config option"}}},
+			{"set", {}, cmdSet, {}, 0, -1, "set <key> <value> <true|false>",
+				{"<config_key>"},
+				{{"set <key> <value> <true|false>", "Set config in realtime (true=persist)"}}},
+		});
+		return registry;
+	}
+
+	/// Reports background jobs that finished since the last prompt.
+	void reportFinishedJobs() {
+		for (auto& s : sessions) {
+			if (!s.job || !s.active || !s.job->finished) continue;
+			s.active = false;
+			std::cout << COLOR_GREEN << "[ DONE ]" << COLOR_RESET << " Session " << s.id << " (" << s.info << ") finished"
+				<< COLOR_GRAY << " - `session resume " << s.id << "` shows its output" << COLOR_RESET << "\n";
+		}
+	}
+
+	/**
+	 * Cancels running jobs on exit and waits until each has finished, snapshot
+	 * included; cancelling ends their child processes, so the wait is short.
+	 */
+	void stopJobs() {
+		for (auto& s : sessions)
+			if (s.job) s.job->token.cancel();
+		for (auto& s : sessions)
+			while (s.job && !s.job->finished)
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	/// Sends output written for background jobs to the jobs instead of the terminal.
+	void routeJobOutput() {
+		terminalWriter.start(std::cout.rdbuf());
+		static JobOutputRouter coutRouter(std::cout.rdbuf(), false);
+		static JobOutputRouter cerrRouter(std::cerr.rdbuf(), true);
+		std::cout.rdbuf(&coutRouter);
+		std::cerr.rdbuf(&cerrRouter);
+	}
+
+	/// Runs a command on the foreground; Ctrl-C cancels its work instead of ending tcli.
+	bool runForeground(const std::string& line, bool* cancelled = nullptr, bool* failed = nullptr) {
+		auto job = std::make_shared<Job>();
+		job->captured = false;
+		platform::InterruptScope interrupts;
+		std::mutex doneMutex;
+		std::condition_variable doneCv;
+		bool done = false;
+		std::thread watcher([&] {
+			std::unique_lock<std::mutex> lock(doneMutex);
+			while (!doneCv.wait_for(lock, std::chrono::milliseconds(20), [&] { return done; })) {
+				if (platform::takeInterrupt() && !job->token.cancelled()) {
+					job->token.cancel();
+					std::cerr << COLOR_YELLOW << "\n[ STOP ]" << COLOR_RESET << " Cancelling...\n";
+				}
+			}
+		});
+		currentJob = job;
+		bool known = commandRegistry().dispatch(line);
+		currentJob.reset();
+		{
+			std::lock_guard<std::mutex> lock(doneMutex);
+			done = true;
+		}
+		doneCv.notify_all();
+		watcher.join();
+		if (cancelled) *cancelled = job->token.cancelled();
+		if (failed) *failed = job->failed;
+		return known;
+	}
+
+	// -------------------------------------------------------------------------
+	// Batch Mode
+	// -------------------------------------------------------------------------
+
+	/// Splits `text` into commands at `;` outside quotes; `#` outside quotes starts a comment.
+	void splitCommands(std::string_view text, std::vector<std::string>& out) {
+		std::string current;
+		char quote = 0;
+		auto push = [&] {
+			size_t b = current.find_first_not_of(" \t\r");
+			if (b != std::string::npos) out.push_back(current.substr(b, current.find_last_not_of(" \t\r") + 1 - b));
+			current.clear();
+		};
+		for (size_t i = 0; i < text.size(); ++i) {
+			char c = text[i];
+			if (quote) {
+				if (c == quote) quote = 0;
+			} else if (c == '"' || c == '\'') {
+				quote = c;
+			} else if (c == ';' || c == '\n') {
+				push();
+				continue;
+			} else if (c == '#' && current.find_first_not_of(" \t") == std::string::npos) {
+				i = std::min(text.find('\n', i), text.size()) - 1;
+				continue;
+			}
+			current += c;
+		}
+		push();
+	}
+
+	/**
+	 * Runs commands without a terminal: no banner, loading bar, prompt,
+	 * highlighting or history. A trailing `&` is ignored, since nothing is
+	 * left to come back to. Returns the process exit code: 0 when every
+	 * command succeeded, 1 when any failed or was unknown, 130 when one was
+	 * interrupted.
+	 */
+	int runBatch(const std::vector<std::string>& commands) {
+		routeJobOutput();
+		loadConfig("TCLI", false);
+		commandHistory.open("");
+		int status = 0;
+		for (std::string line : commands) {
+			if (shouldClose) break;
+			size_t last = line.find_last_not_of(' ');
+			if (last != std::string::npos && line[last] == '&') {
+				line.erase(last);
+				line.erase(line.find_last_not_of(' ') + 1);
+			}
+			bool cancelled = false, failed = false;
+			if (!runForeground(line, &cancelled, &failed)) {
+				std::cerr << "Unknown command: " << line.substr(0, line.find(' ')) << "\n";
+				failed = true;
+			}
+			if (cancelled) return 130;
+			if (failed) status = 1;
+		}
+		std::cout.flush();
+		return status;
+	}
+
+	// -------------------------------------------------------------------------
+	// Daemon Mode
+	// -------------------------------------------------------------------------
+
+	/*
+	 * `tcli --daemon` keeps one process, with its sessions, caches and request
+	 * budget, alive behind a UNIX domain socket; `tcli --connect` clients send
+	 * it commands. Both directions use frames of a type byte, a 32-bit little
+	 * endian length and the payload:
+	 *   client -> daemon   'C' command line, 'K' cancel the running command
+	 *   daemon -> client   'O' stdout text, 'E' stderr text, 'X' exit status (one byte)
+	 */
+
+	std::string frame(char type, std::string_view payload) {
+		std::string out(1, type);
+		putU32(out, static_cast<uint32_t>(payload.size()));
+		out += payload;
+		return out;
+	}
+
+	/// Splits frames out of a socket's byte stream.
+	class FrameReader {
+	public:
+		explicit FrameReader(int fd) : fd(fd) {}
+
+		/**
+		 * Takes the next frame, waiting up to `timeoutMs` (negative: forever).
+		 * False if none arrived in time or the peer is gone (then `closed` is set).
+		 */
+		bool next(char& type, std::string& payload, int timeoutMs = -1) {
+			while (true) {
+				if (buffer.size() >= 5) {
+					uint32_t size = 0;
+					for (int i = 0; i < 4; ++i) size |= static_cast<uint32_t>(static_cast<unsigned char>(buffer[1 + i])) << (8 * i);
+					if (buffer.size() >= 5 + size) {
+						type = buffer[0];
+						payload.assign(buffer, 5, size);
+						buffer.erase(0, 5 + size);
+						return true;
+					}
+				}
+				char chunk[4096];
+				long got = platform::receive(fd, chunk, sizeof(chunk), timeoutMs);
+				if (got < 0) return false;
+				if (got == 0) {
+					closed = true;
+					return false;
+				}
+				buffer.append(chunk, static_cast<size_t>(got));
+			}
+		}
+
+		bool closed = false;
+
+	private:
+		int fd;
+		std::string buffer;
+	};
+
+	/**
+	 * Frames waiting to go out to one daemon client, sent by a thread of the
+	 * client's own. Posting never blocks, so the TerminalWriter and job
+	 * threads never wait on a socket, and a client that stops reading stalls
+	 * only itself. Past `limit` queued bytes the client counts as gone.
+	 */
+	class ClientOutbox {
+	public:
+		explicit ClientOutbox(int fd) : fd(fd), sender([this] { run(); }) {}
+		~ClientOutbox() { close(); }
+
+		/// Queues a frame; false once the client has fallen too far behind or its socket failed.
+		bool post(std::string frame) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (failedFlag) return false;
+			if (queued + frame.size() > limit) {
+				failedFlag = true;
+				frames.clear();
+				cv.notify_one();
+				return false;
+			}
+			queued += frame.size();
+			frames.push_back(std::move(frame));
+			cv.notify_one();
+			return true;
+		}
+
+		bool failed() const {
+			std::lock_guard<std::mutex> lock(mutex);
+			return failedFlag;
+		}
+
+		/// Sends what is still queued (unless the client failed), then stops the sender.
+		void close() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				closing = true;
+				cv.notify_one();
+			}
+			if (sender.joinable()) sender.join();
+		}
+
+	private:
+		static constexpr size_t limit = 4 << 20;
+
+		int fd;
+		mutable std::mutex mutex;
+		std::condition_variable cv;
+		std::deque<std::string> frames;
+		size_t queued = 0;
+		bool closing = false;
+		bool failedFlag = false;
+		std::thread sender;
+
+		void run() {
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true) {
+				cv.wait(lock, [&] { return !frames.empty() || closing || failedFlag; });
+				if (failedFlag || frames.empty()) return;
+				std::string next = std::move(frames.front());
+				frames.pop_front();
+				queued -= next.size();
+				lock.unlock();
+				bool sent = platform::sendAll(fd, next);
+				lock.lock();
+				if (!sent) {
+					failedFlag = true;
+					frames.clear();
+				}
+			}
+		}
+	};
+
+	/// Serialises commands that touch shared CLI state (sessions, config, history) across clients.
+	static std::mutex daemonCommandMutex;
+
+	/// A connected client: the thread serving it and the command it runs, so shutdown can reach both.
+	struct DaemonClient {
+		int fd = -1;                   ///< Closed by runDaemon once the thread is joined
+		std::shared_ptr<Job> job;      ///< Guarded by daemonClientsMutex
+		std::atomic<bool> done{false};
+		std::thread thread;
+	};
+
+	static std::mutex daemonClientsMutex;
+	static std::atomic<bool> daemonStopping{false};   ///< Set under daemonClientsMutex
+
+	/**
+	 * Runs one client's commands. Output of each command streams back as it is
+	 * written; crawls and scans run concurrently with other clients, anything
+	 * else one at a time. A cancel frame, a dropped connection or a client too
+	 * far behind on its output cancels the running command. When the daemon
+	 * stops, the running command is cancelled and still answered with its status.
+	 */
+	void serveClient(DaemonClient& client) {
+		int fd = client.fd;
+		FrameReader in(fd);
+		ClientOutbox out(fd);
+		char type;
+		std::string line;
+		while (in.next(type, line)) {
+			if (type != 'C') continue;
+			const CommandSpec* spec = commandRegistry().find(line.substr(0, line.find(' ')));
+			if (spec && spec->handler == cmdQuit) {
+				out.post(frame('X', std::string(1, '\0')));
+				break;
+			}
+			auto job = std::make_shared<Job>();
+			job->stream = [&out, token = &job->token](bool error, std::string_view data) {
+				if (!out.post(frame(error ? 'E' : 'O', data))) token->cancel();
+			};
+			{
+				std::lock_guard<std::mutex> lock(daemonClientsMutex);
+				client.job = job;
+				if (daemonStopping) job->token.cancel();
+			}
+			size_t last = line.find_last_not_of(' ');
+			bool background = last != std::string::npos && line[last] == '&';
+			if (background) {
+				line.erase(last);
+				line.erase(line.find_last_not_of(' ') + 1);
+			}
+			std::future<void> task = std::async(std::launch::async, [&] {
+				std::unique_lock<std::mutex> exclusive(daemonCommandMutex, std::defer_lock);
+				if (!spec || background || !spec->background) exclusive.lock();
+				currentJob = job;
+				if (!(background ? commandRegistry().dispatchBackground(line) : commandRegistry().dispatch(line))) {
+					std::cerr << "Unknown command: " << line.substr(0, line.find(' ')) << "\n";
+					job->failed = true;
+				}
+				std::cout.flush();
+				currentJob.reset();
+			});
+			while (task.wait_for(std::chrono::milliseconds(20)) != std::future_status::ready) {
+				char control;
+				std::string ignored;
+				if ((in.next(control, ignored, 0) && control == 'K') || in.closed || out.failed()) job->token.cancel();
+			}
+			{
+				std::lock_guard<std::mutex> lock(daemonClientsMutex);
+				client.job.reset();
+			}
+			if ((in.closed && !daemonStopping) || out.failed()) break;
+			out.post(frame('X', std::string(1, static_cast<char>(job->token.cancelled() ? 130 : job->failed ? 1 : 0))));
+			if (in.closed) break;
+		}
+		out.close();
+		client.done = true;
+	}
+
+	/// Serves clients on the socket at `socketPath` (default `daemon_socket`) until SIGINT or SIGTERM.
+	int runDaemon(std::string socketPath) {
+		routeJobOutput();
+		loadConfig("TCLI", false);
+		commandHistory.open(config["history_file"]);
+		loadSavedSessions();
+		std::cin.setstate(std::ios::eofbit);  // no console: confirmations answer "no"
+		if (socketPath.empty()) socketPath = config["daemon_socket"];
+		int listener = platform::listenLocal(socketPath);
+		if (listener < 0) {
+			std::cerr << COLOR_RED << "[ FAIL ]" << COLOR_RESET << " Cannot listen on " << socketPath
+					  << " (unsupported here, path too long, or another daemon is running).\n";
+			return 1;
+		}
+		std::cout << COLOR_GREEN << "[ OK ]" << COLOR_RESET << " Daemon listening on " << socketPath << "\n" << std::flush;
+		platform::InterruptScope stop(true);
+		std::list<DaemonClient> clients;
+		auto reap = [&](DaemonClient& client) {
+			client.thread.join();
+			platform::closeSocket(client.fd);
+		};
+		while (!platform::takeInterrupt()) {
+			int fd = platform::acceptLocal(listener, 200);
+			for (auto it = clients.begin(); it != clients.end();) {
+				if (!it->done) {
+					++it;
+					continue;
+				}
+				reap(*it);
+				it = clients.erase(it);
+			}
+			if (fd < 0) continue;
+			DaemonClient& client = clients.emplace_back();
+			client.fd = fd;
+			client.thread = std::thread(serveClient, std::ref(client));
+		}
+		platform::closeSocket(listener);
+		fs::remove(socketPath);
+		std::cout << COLOR_YELLOW << "[ STOP ]" << COLOR_RESET << " Daemon stopping; unfinished crawls are saved.\n";
+		// Cancel what clients run and stop reading from them; each still gets its command's status.
+		{
+			std::lock_guard<std::mutex> lock(daemonClientsMutex);
+			daemonStopping = true;
+			for (DaemonClient& client : clients) {
+				if (client.job) client.job->token.cancel();
+				platform::shutdownSocket(client.fd, true, false);
+			}
+		}
+		// A client that stopped reading can't take its last frames; cut it off after a grace period.
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+		for (DaemonClient& client : clients)
+			while (!client.done && std::chrono::steady_clock::now() < deadline)
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		for (DaemonClient& client : clients) {
+			if (!client.done) platform::shutdownSocket(client.fd, true, true);
+			reap(client);
+		}
+		stopJobs();
+		return 0;
+	}
+
+	/**
+	 * Thin client for a daemon: sends `commands` (or, when there are none, each
+	 * line read from stdin) and streams back their output. Ctrl-C cancels the
+	 * command running in the daemon. Exit codes match batch mode.
+	 */
+	int runClient(std::string socketPath, const std::vector<std::string>& commands) {
+		if (socketPath.empty()) {
+			loadConfig("TCLI", false);
+			socketPath = config["daemon_socket"];
+		}
+		int fd = platform::connectLocal(socketPath);
+		if (fd < 0) {
+			std::cerr << "tcli: no daemon listening on " << socketPath << " (start one with `tcli --daemon`)\n";
+			return 2;
+		}
+		FrameReader in(fd);
+		platform::InterruptScope interrupts;
+		int status = 0;
+		auto run = [&](const std::string& command) {
+			platform::sendAll(fd, frame('C', command));
+			char type;
+			std::string payload, plain;
+			while (true) {
+				if (!in.next(type, payload, 50)) {
+					if (in.closed) return false;
+					if (platform::takeInterrupt()) platform::sendAll(fd, frame('K', ""));
+					continue;
+				}
+				if ((type == 'O' || type == 'E') && !colorEnabled(type == 'E')) {
+					// The daemon colors its output; drop that here when ours goes to a pipe.
+					plain.clear();
+					appendWithoutColor(plain, payload);
+					payload.swap(plain);
+				}
+				if (type == 'O') std::cout << payload << std::flush;
+				else if (type == 'E') std::cerr << payload << std::flush;
+				else if (type == 'X') {
+					int code = payload.empty() ? 1 : static_cast<unsigned char>(payload[0]);
+					if (code == 130) status = 130;
+					else if (code && status != 130) status = 1;
+					return code != 130;
+				}
+			}
+		};
+		// The daemon answers quit and then hangs up, so nothing after it can run.
+		auto quits = [](const std::string& command) {
+			const CommandSpec* spec = commandRegistry().find(command.substr(0, command.find(' ')));
+			return spec && spec->handler == cmdQuit;
+		};
+		bool more = true;
+		for (const std::string& command : commands)
+			if (!(more = run(command) && !quits(command))) break;
+		if (commands.empty()) {
+			for (std::string text; more && std::getline(std::cin, text);) {
+				std::vector<std::string> lines;
+				splitCommands(text, lines);
+				for (const std::string& command : lines)
+					if (!(more = run(command) && !quits(command))) break;
+			}
+		}
+		if (in.closed && status == 0) {
+			std::cerr << "tcli: daemon closed the connection\n";
+			status = 1;
+		}
+		platform::closeSocket(fd);
+		return status;
+	}
+
 	void cliLoop() {
+		routeJobOutput();
 		helloBanner();
 		loadConfig("TCLI");
 		loadingBar("Loading TCLI");
-		std::vector<std::string> history;
+		commandHistory.open(config["history_file"]);
+		loadSavedSessions();
 		while (!shouldClose) {
-			std::string line = readLineWithArrows(history);
+			reportFinishedJobs();
+			std::string line = readLineWithArrows(commandHistory);
 			if (line.empty()) continue;
-			history.push_back(line);
-			globalHistory.push_back(line);
-			size_t space = line.find(' ');
-			std::string cmd = (space == std::string::npos) ? line : line.substr(0, space);
-			std::string args = (space == std::string::npos) ? "" : line.substr(space + 1);
-			if (cmd == "quit" || cmd == "exit") cmdQuit(args);
-			else if (cmd == "clr" || cmd == "clear") cmdClear(args);
-			else if (cmd == "rl" || cmd == "reload") cmdReload(args);
-			else if (cmd == "tcli" && args == "setup") cmdSetup(args);
-			else if (cmd == "connect") cmdConnect(args);
-			else if (cmd == "ld") {
-				if (args == "local") cmdListLocal(args);
-				else if (args == "global") cmdListGlobal(args);
-				else std::cerr << COLOR_GRAY << "Usage: ld local|global" << COLOR_RESET << "\n";
-			} else if (cmd == "help" || cmd == "--help" || cmd == "-h") {
-				cmdHelp(args);
-			} else if (cmd == "enum") {
-				cmdEnum(args);
-			} else if (cmd == "break") {
-				cmdBreak(args);
-			} else if (cmd == "scan") {
-				cmdScan(args);
-			} else if (cmd == "inject") {
-				cmdInject(args);
-			} else if (cmd == "auth_bypass") {
-				cmdAuthBypass(args);
-			} else if (cmd == "spoof") {
-				cmdSpoof(args);
-			} else if (cmd == "session") {
-				cmdSession(args);
-			} else if (cmd == "history") {
-				cmdHistory(args);
-			} else if (cmd == "payload_gen") {
-				cmdPayloadGen(args);
-			} else if (cmd == "config") {
-				cmdConfig(args);
-			} else if (cmd == "set") {
-				cmdSet(args);
-			} else {
+			commandHistory.push(line);
+			size_t last = line.find_last_not_of(' ');
+			bool background = last != std::string::npos && line[last] == '&';
+			if (background) {
+				line.erase(last);
+				line.erase(line.find_last_not_of(' ') + 1);
+			}
+			if (!(background ? commandRegistry().dispatchBackground(line) : runForeground(line))) {
+				std::string cmd = line.substr(0, line.find(' '));
 				std::cerr << COLOR_GRAY << "Unknown command: " << cmd << "\nType `help` for a list of available commands." << COLOR_RESET << "\n";
 			}
 		}
+		stopJobs();
 	}
 }
 
@@ -1405,7 +5406,44 @@ namespace CLI {
 // Main Entry Point
 // -----------------------------------------------------------------------------
 
-int main() {
+int main(int argc, char** argv) {
+	// tcli -c "cmd; cmd" and tcli -f script.tcli run without a terminal;
+	// --daemon serves commands on a socket and --connect sends them there
+	std::vector<std::string> commands;
+	std::string socketPath;
+	bool batch = false, daemon = false, client = false;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--daemon") {
+			daemon = true;
+		} else if (arg == "--connect") {
+			client = true;
+		} else if (arg == "--socket" && i + 1 < argc) {
+			socketPath = argv[++i];
+		} else if ((arg == "-c" || arg == "-f") && i + 1 < argc) {
+			batch = true;
+			std::string text = argv[++i];
+			if (arg == "-f") {
+				std::ifstream script;
+				if (text != "-") script.open(text);
+				if (text != "-" && !script) {
+					std::cerr << "tcli: cannot read script '" << text << "'\n";
+					return 2;
+				}
+				std::ostringstream content;
+				content << (text == "-" ? std::cin.rdbuf() : script.rdbuf());
+				text = content.str();
+			}
+			CLI::splitCommands(text, commands);
+		} else {
+			std::cerr << "Usage: tcli [--connect] [--socket path] [-c \"cmd; cmd\"] [-f script.tcli|-]\n"
+					  << "       tcli --daemon [--socket path]\n";
+			return 2;
+		}
+	}
+	if (daemon) return CLI::runDaemon(socketPath);
+	if (client) return CLI::runClient(socketPath, commands);
+	if (batch) return CLI::runBatch(commands);
 	platform::setTerminalTitle("TCLI - Tactical CLI");
 	CLI::cliLoop();
 	return 0;
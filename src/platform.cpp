@@ -9,8 +9,21 @@
  *
  * Features include:
  *   - Clearing the terminal screen on both Windows and UNIX-like systems
- *   - Reading single keypresses without requiring Enter (getch), with echo suppression
+ *   - Reading single keypresses without requiring Enter (getch), with echo suppression,
+ *     served from a buffered read(2) queue
+ *   - Terminal sessions that hold raw mode (and bracketed paste) for a whole
+ *     prompt and restore the terminal on exit and on signals
+ *   - Non-blocking peeks at pending input so pasted bursts can be drained at once
  *   - Dynamically setting the terminal window title for enhanced user experience
+ *   - Querying the terminal width for line wrapping
+ *   - Writing whole rendered frames with a single write(2)
+ *   - Memory-mapped file views, locked appends and atomic file replacement
+ *     for the shared command history
+ *   - Turning Ctrl-C into a cancellation request for the running command, and
+ *     running shell commands in their own process group so they can be stopped
+ *   - Host name resolution for the shared DNS cache
+ *   - Lowering thread priority for background work
+ *   - UNIX domain sockets for the daemon's control API
  *
  * All functions are encapsulated within the `platform` namespace to ensure
  * modularity and prevent naming conflicts.
@@ -26,13 +39,126 @@
 #ifdef _WIN32
 #include <windows.h>
 #else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 #include <termios.h>
 #include <unistd.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+
+extern char** environ;
 #endif
 
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <utility>
 
 namespace platform {
+    #ifndef _WIN32
+    namespace {
+        struct termios savedTermios;
+        volatile std::sig_atomic_t rawActive = 0;
+        int sessionDepth = 0;
+
+        char inputBuffer[4096];
+        size_t inputHead = 0;
+        size_t inputTail = 0;
+
+        volatile std::sig_atomic_t interruptPending = 0;
+        struct sigaction interruptPrevious;
+        struct sigaction terminatePrevious;
+
+        void onInterrupt(int) {
+            interruptPending = 1;
+        }
+
+        const int restoreSignals[] = {SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGTSTP, SIGCONT};
+        struct sigaction previousActions[sizeof(restoreSignals) / sizeof(restoreSignals[0])];
+
+        void enterRaw() {
+            struct termios raw = savedTermios;
+            raw.c_lflag &= ~(ICANON | ECHO);
+            raw.c_cc[VINTR] = _POSIX_VDISABLE; // Ctrl-C reaches the line editor as a key
+            raw.c_cc[VMIN] = 1;
+            raw.c_cc[VTIME] = 0;
+            tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+            static const char pasteOn[] = "\033[?2004h";
+            if (write(STDOUT_FILENO, pasteOn, sizeof(pasteOn) - 1) < 0) {}
+            rawActive = 1;
+        }
+
+        void leaveRaw() {
+            if (!rawActive) return;
+            static const char pasteOff[] = "\033[?2004l";
+            if (write(STDOUT_FILENO, pasteOff, sizeof(pasteOff) - 1) < 0) {}
+            tcsetattr(STDIN_FILENO, TCSANOW, &savedTermios);
+            rawActive = 0;
+        }
+
+        struct sigaction* previousFor(int sig) {
+            for (size_t i = 0; i < sizeof(restoreSignals) / sizeof(restoreSignals[0]); ++i)
+                if (restoreSignals[i] == sig) return &previousActions[i];
+            return nullptr;
+        }
+
+        /// Restores the terminal, then lets the signal do whatever it did before the session.
+        void onSignal(int sig) {
+            int savedErrno = errno;
+            if (sig == SIGCONT) {
+                if (sessionDepth > 0) enterRaw();
+            } else {
+                leaveRaw();
+                struct sigaction mine;
+                sigaction(sig, previousFor(sig), &mine);
+                sigset_t unblock;
+                sigemptyset(&unblock);
+                sigaddset(&unblock, sig);
+                sigprocmask(SIG_UNBLOCK, &unblock, nullptr);
+                raise(sig);
+                // Only reached when the signal did not end the process (SIGTSTP after a
+                // continue, or a previous handler that returned).
+                sigaction(sig, &mine, nullptr);
+                if (sessionDepth > 0) enterRaw();
+            }
+            errno = savedErrno;
+        }
+
+        /// Refills the empty input queue with one read(2); false at end of input.
+        bool fillInput() {
+            ssize_t n;
+            do {
+                n = read(STDIN_FILENO, inputBuffer, sizeof(inputBuffer));
+            } while (n < 0 && errno == EINTR);
+            if (n <= 0) return false;
+            inputHead = 0;
+            inputTail = static_cast<size_t>(n);
+            return true;
+        }
+
+        /// Returns the next queued input byte, refilling the queue when empty.
+        int nextInputByte() {
+            if (inputHead == inputTail && !fillInput()) return EOF;
+            return static_cast<unsigned char>(inputBuffer[inputHead++]);
+        }
+    }
+    #endif
+
     /**
      * @brief Clears the terminal screen.
      *
@@ -60,14 +186,69 @@ namespace platform {
         #ifdef _WIN32
         return _getch();
         #else
-        struct termios oldt, newt;
-        tcgetattr(STDIN_FILENO, &oldt);
-        newt = oldt;
-        newt.c_lflag &= ~(ICANON | ECHO);
-        tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-        int ch = getchar();
-        tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-        return ch;
+        if (sessionDepth > 0 || inputHead != inputTail) return nextInputByte();
+        TerminalSession session;
+        return nextInputByte();
+        #endif
+    }
+
+    /**
+     * @brief Peeks at the next input byte without blocking.
+     *
+     * Serves from the input queue when it holds data; otherwise polls stdin
+     * with a zero timeout and refills the queue only if input is ready.
+     *
+     * @return The next input byte, or EOF if nothing is pending.
+     */
+    int peekch() {
+        #ifdef _WIN32
+        return EOF;
+        #else
+        if (inputHead == inputTail) {
+            struct pollfd pfd{STDIN_FILENO, POLLIN, 0};
+            if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLIN) || !fillInput()) return EOF;
+        }
+        return static_cast<unsigned char>(inputBuffer[inputHead]);
+        #endif
+    }
+
+    /**
+     * @brief Enters raw mode for the lifetime of the session.
+     *
+     * Saves the current terminal settings once, switches off canonical mode
+     * and echo, turns on bracketed paste, and installs handlers so the saved settings come back on
+     * SIGINT, SIGTERM, SIGHUP, SIGQUIT and SIGTSTP. Does nothing when stdin is
+     * not a terminal or a session is already active.
+     */
+    TerminalSession::TerminalSession() {
+        #ifndef _WIN32
+        if (sessionDepth++ > 0 || !isatty(STDIN_FILENO)) return;
+        if (tcgetattr(STDIN_FILENO, &savedTermios) != 0) return;
+        static bool exitHookInstalled = false;
+        if (!exitHookInstalled) {
+            std::atexit(leaveRaw);
+            exitHookInstalled = true;
+        }
+        struct sigaction sa{};
+        sa.sa_handler = onSignal;
+        sigemptyset(&sa.sa_mask);
+        for (size_t i = 0; i < sizeof(restoreSignals) / sizeof(restoreSignals[0]); ++i)
+            sigaction(restoreSignals[i], &sa, &previousActions[i]);
+        enterRaw();
+        owner = true;
+        #endif
+    }
+
+    /**
+     * @brief Restores the terminal settings and signal handlers saved by the constructor.
+     */
+    TerminalSession::~TerminalSession() {
+        #ifndef _WIN32
+        --sessionDepth;
+        if (!owner) return;
+        leaveRaw();
+        for (size_t i = 0; i < sizeof(restoreSignals) / sizeof(restoreSignals[0]); ++i)
+            sigaction(restoreSignals[i], &previousActions[i], nullptr);
         #endif
     }
 
@@ -87,4 +268,526 @@ namespace platform {
         std::cout.flush();
         #endif
     }
+
+    /**
+     * @brief Writes a block of bytes straight to the terminal.
+     *
+     * Loops over partial writes and EINTR so the caller's frame goes out
+     * with as few write(2) calls as the kernel allows (normally one).
+     *
+     * @param data The bytes to write.
+     */
+    void writeOutput(const std::string& data) {
+        #ifdef _WIN32
+        DWORD written;
+        WriteConsoleA(GetStdHandle(STD_OUTPUT_HANDLE), data.data(), static_cast<DWORD>(data.size()), &written, nullptr);
+        #else
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = write(STDOUT_FILENO, data.data() + done, data.size() - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            done += static_cast<size_t>(n);
+        }
+        #endif
+    }
+
+    /**
+     * @brief Returns the width of the terminal in columns.
+     *
+     * Queries the console buffer on Windows and TIOCGWINSZ elsewhere,
+     * defaulting to 80 columns if the query fails.
+     *
+     * @return The number of columns in the terminal window.
+     */
+    int terminalWidth() {
+        #ifdef _WIN32
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+            return info.srWindow.Right - info.srWindow.Left + 1;
+        return 80;
+        #else
+        struct winsize ws;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0)
+            return ws.ws_col;
+        return 80;
+        #endif
+    }
+
+    /**
+     * @brief Tells whether stdout (or stderr) is attached to a terminal.
+     *
+     * Asks for the console mode on Windows and uses isatty(3) elsewhere.
+     *
+     * @param errors Check stderr instead of stdout.
+     * @return True if the stream is a terminal.
+     */
+    bool isTerminal(bool errors) {
+        #ifdef _WIN32
+        DWORD mode;
+        return GetConsoleMode(GetStdHandle(errors ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE), &mode) != 0;
+        #else
+        return isatty(errors ? STDERR_FILENO : STDOUT_FILENO) != 0;
+        #endif
+    }
+
+    /**
+     * @brief Maps `path` read-only.
+     *
+     * Uses mmap(2) on POSIX systems; elsewhere the file is read into memory.
+     * Any failure leaves the view empty.
+     *
+     * @param path The file to map.
+     */
+    MappedFile::MappedFile(const std::string& path) {
+        #ifdef _WIN32
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return;
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        owned = contents.str();
+        bytes = owned.data();
+        length = owned.size();
+        #else
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) {
+                bytes = static_cast<const char*>(addr);
+                length = static_cast<size_t>(st.st_size);
+            }
+        }
+        close(fd);
+        #endif
+    }
+
+    /**
+     * @brief Unmaps the file.
+     */
+    MappedFile::~MappedFile() {
+        #ifndef _WIN32
+        if (bytes && owned.empty()) munmap(const_cast<char*>(bytes), length);
+        #endif
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            #ifndef _WIN32
+            if (bytes && owned.empty()) munmap(const_cast<char*>(bytes), length);
+            #endif
+            owned = std::move(other.owned);
+            bytes = owned.empty() ? other.bytes : owned.data();
+            length = other.length;
+            other.bytes = nullptr;
+            other.length = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Appends a block of bytes to a file in one locked write.
+     *
+     * O_APPEND places every write at the current end of file, and flock(2)
+     * keeps a block from another process out of the middle of ours should the
+     * kernel split the write.
+     *
+     * @param path The file to append to.
+     * @param data The bytes to append.
+     * @param offset If given, receives the file offset the block was written at.
+     * @return True if every byte was written.
+     */
+    bool appendFile(const std::string& path, std::string_view data, std::uint64_t* offset) {
+        #ifdef _WIN32
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file.seekp(0, std::ios::end);
+        if (offset) *offset = static_cast<std::uint64_t>(file.tellp());
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        return static_cast<bool>(file);
+        #else
+        int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return false;
+        flock(fd, LOCK_EX);
+        // Every appender holds the lock, so the end seen here is where the block lands.
+        if (offset) *offset = static_cast<std::uint64_t>(lseek(fd, 0, SEEK_END));
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = write(fd, data.data() + done, data.size() - done);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            done += static_cast<size_t>(n);
+        }
+        flock(fd, LOCK_UN);
+        close(fd);
+        return done == data.size();
+        #endif
+    }
+
+    /**
+     * @brief Writes a header into a file that is missing or empty, under the same lock as appendFile().
+     *
+     * The size is checked only once the lock is held, so a header written by
+     * another process in the meantime is seen and not repeated.
+     *
+     * @param path The file to start.
+     * @param header The bytes that open the file.
+     * @return True if the file now has content (ours or another process's).
+     */
+    bool startFile(const std::string& path, std::string_view header) {
+        #ifdef _WIN32
+        std::ifstream existing(path, std::ios::binary | std::ios::ate);
+        if (existing && existing.tellg() > 0) return true;
+        existing.close();
+        return appendFile(path, header);
+        #else
+        int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+        if (fd < 0) return false;
+        flock(fd, LOCK_EX);
+        struct stat st{};
+        bool ok = fstat(fd, &st) == 0;
+        if (ok && st.st_size == 0) {
+            size_t done = 0;
+            while (done < header.size()) {
+                ssize_t n = write(fd, header.data() + done, header.size() - done);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    break;
+                }
+                done += static_cast<size_t>(n);
+            }
+            ok = done == header.size();
+        }
+        flock(fd, LOCK_UN);
+        close(fd);
+        return ok;
+        #endif
+    }
+
+    /**
+     * @brief Atomically replaces a file's contents.
+     *
+     * The temporary file carries the process id so concurrent replacements
+     * do not clobber each other's half-written data; the last rename wins.
+     *
+     * @param path The file to replace.
+     * @param data The new contents.
+     * @return True on success.
+     */
+    bool replaceFile(const std::string& path, std::string_view data) {
+        #ifdef _WIN32
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        return static_cast<bool>(file);
+        #else
+        std::string temp = path + ".tmp." + std::to_string(getpid());
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            file.write(data.data(), static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                std::remove(temp.c_str());
+                return false;
+            }
+        }
+        if (std::rename(temp.c_str(), path.c_str()) != 0) {
+            std::remove(temp.c_str());
+            return false;
+        }
+        return true;
+        #endif
+    }
+
+    /**
+     * @brief Installs the recording SIGINT (and optionally SIGTERM) handler, with SA_RESTART.
+     */
+    InterruptScope::InterruptScope(bool terminate) : terminate(terminate) {
+        #ifndef _WIN32
+        interruptPending = 0;
+        struct sigaction sa{};
+        sa.sa_handler = onInterrupt;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGINT, &sa, &interruptPrevious);
+        if (terminate) sigaction(SIGTERM, &sa, &terminatePrevious);
+        #endif
+    }
+
+    /**
+     * @brief Puts back the dispositions that were active before the scope.
+     */
+    InterruptScope::~InterruptScope() {
+        #ifndef _WIN32
+        sigaction(SIGINT, &interruptPrevious, nullptr);
+        if (terminate) sigaction(SIGTERM, &terminatePrevious, nullptr);
+        #endif
+    }
+
+    /**
+     * @brief Reports and clears a Ctrl-C recorded by an InterruptScope.
+     *
+     * @return True if SIGINT arrived since the last call.
+     */
+    bool takeInterrupt() {
+        #ifdef _WIN32
+        return false;
+        #else
+        if (!interruptPending) return false;
+        interruptPending = 0;
+        return true;
+        #endif
+    }
+
+    /**
+     * @brief Runs a shell command and returns everything it wrote to stdout.
+     *
+     * Uses posix_spawn with POSIX_SPAWN_SETPGROUP rather than popen so the child
+     * gets its own process group, and a close-on-exec pipe so commands spawned
+     * concurrently from other threads never inherit each other's pipe ends.
+     * Falls back to _popen on Windows.
+     *
+     * @param command The shell command line.
+     * @param started Optional callback with the child's process id.
+     * @return The command's standard output.
+     */
+    std::string runCommand(const std::string& command, const std::function<void(int pid)>& started) {
+        std::string output;
+        char buffer[4096];
+        #ifdef _WIN32
+        FILE* pipe = _popen(command.c_str(), "r");
+        if (!pipe) return output;
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+            output.append(buffer, n);
+        _pclose(pipe);
+        #else
+        int fds[2];
+        #ifdef __linux__
+        if (pipe2(fds, O_CLOEXEC) != 0) return output;
+        #else
+        if (pipe(fds) != 0) return output;
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        #endif
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attr, 0);
+        std::string shell = "sh", flag = "-c", line = command;
+        char* argv[] = {shell.data(), flag.data(), line.data(), nullptr};
+        pid_t pid;
+        int rc = posix_spawn(&pid, "/bin/sh", &actions, &attr, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attr);
+        close(fds[1]);
+        if (rc != 0) {
+            close(fds[0]);
+            return output;
+        }
+        if (started) started(static_cast<int>(pid));
+        for (;;) {
+            ssize_t n = read(fds[0], buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            output.append(buffer, static_cast<size_t>(n));
+        }
+        close(fds[0]);
+        int status;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+        #endif
+        return output;
+    }
+
+    /**
+     * @brief Terminates a process started by runCommand() and its process group.
+     *
+     * @param pid The id passed to runCommand()'s `started` callback.
+     */
+    void terminateProcess(int pid) {
+        #ifndef _WIN32
+        if (pid > 0) kill(-pid, SIGTERM);
+        #endif
+    }
+
+    std::string resolveHost(const std::string& host) {
+        #ifdef _WIN32
+        (void)host;
+        return "";
+        #else
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* found = nullptr;
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &found) != 0 || !found) return "";
+        const addrinfo* pick = found;
+        for (const addrinfo* a = found; a; a = a->ai_next) {
+            if (a->ai_family == AF_INET) { pick = a; break; }
+        }
+        char text[INET6_ADDRSTRLEN] = {0};
+        std::string address;
+        if (pick->ai_family == AF_INET) {
+            inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in*>(pick->ai_addr)->sin_addr, text, sizeof(text));
+            address = text;
+        } else if (pick->ai_family == AF_INET6) {
+            inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6*>(pick->ai_addr)->sin6_addr, text, sizeof(text));
+            address = std::string("[") + text + "]";
+        }
+        freeaddrinfo(found);
+        return address;
+        #endif
+    }
+
+    void lowerThreadPriority() {
+        #ifdef _WIN32
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+        #elif defined(__linux__)
+        // Linux keeps a nice value per thread; new threads inherit it
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+        #endif
+    }
+
+    #ifndef _WIN32
+    namespace {
+        bool localAddress(const std::string& path, sockaddr_un& address) {
+            address = sockaddr_un{};
+            address.sun_family = AF_UNIX;
+            if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+            std::copy(path.begin(), path.end(), address.sun_path);
+            return true;
+        }
+
+        bool waitReadable(int fd, int timeoutMs) {
+            pollfd p{fd, POLLIN, 0};
+            int ready;
+            do ready = poll(&p, 1, timeoutMs); while (ready < 0 && errno == EINTR);
+            return ready > 0;
+        }
+
+        /// A UNIX stream socket that is not inherited by spawned commands.
+        int localSocket() {
+            #ifdef __linux__
+            return socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            #else
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd >= 0) fcntl(fd, F_SETFD, FD_CLOEXEC);
+            return fd;
+            #endif
+        }
+    }
+    #endif
+
+    int listenLocal(const std::string& path) {
+        #ifdef _WIN32
+        (void)path;
+        return -1;
+        #else
+        sockaddr_un address;
+        if (!localAddress(path, address)) return -1;
+        int probe = connectLocal(path);
+        if (probe >= 0) {
+            close(probe);
+            return -1;
+        }
+        unlink(path.c_str());
+        int fd = localSocket();
+        if (fd < 0) return -1;
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 16) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+        #endif
+    }
+
+    int acceptLocal(int listener, int timeoutMs) {
+        #ifdef _WIN32
+        (void)listener; (void)timeoutMs;
+        return -1;
+        #else
+        if (!waitReadable(listener, timeoutMs)) return -1;
+        #ifdef __linux__
+        return accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        #else
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd >= 0) fcntl(fd, F_SETFD, FD_CLOEXEC);
+        return fd;
+        #endif
+        #endif
+    }
+
+    int connectLocal(const std::string& path) {
+        #ifdef _WIN32
+        (void)path;
+        return -1;
+        #else
+        sockaddr_un address;
+        if (!localAddress(path, address)) return -1;
+        int fd = localSocket();
+        if (fd < 0) return -1;
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+        #endif
+    }
+
+    bool sendAll(int fd, std::string_view data) {
+        #ifdef _WIN32
+        (void)fd; (void)data;
+        return false;
+        #else
+        #ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+        #else
+        const int flags = 0;
+        #endif
+        while (!data.empty()) {
+            ssize_t sent = send(fd, data.data(), data.size(), flags);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent <= 0) return false;
+            data.remove_prefix(static_cast<size_t>(sent));
+        }
+        return true;
+        #endif
+    }
+
+    long receive(int fd, char* buffer, std::size_t size, int timeoutMs) {
+        #ifdef _WIN32
+        (void)fd; (void)buffer; (void)size; (void)timeoutMs;
+        return 0;
+        #else
+        if (!waitReadable(fd, timeoutMs)) return -1;
+        ssize_t got;
+        do got = recv(fd, buffer, size, 0); while (got < 0 && errno == EINTR);
+        return got < 0 ? 0 : static_cast<long>(got);
+        #endif
+    }
+
+    void shutdownSocket(int fd, bool receiving, bool sending) {
+        #ifndef _WIN32
+        if (fd < 0 || (!receiving && !sending)) return;
+        shutdown(fd, receiving && sending ? SHUT_RDWR : receiving ? SHUT_RD : SHUT_WR);
+        #else
+        (void)fd; (void)receiving; (void)sending;
+        #endif
+    }
+
+    void closeSocket(int fd) {
+        #ifndef _WIN32
+        if (fd >= 0) close(fd);
+        #else
+        (void)fd;
+        #endif
+    }
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #ifndef PLATFORM_HPP
 #define PLATFORM_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
 
 /**
  * @file platform.hpp
@@ -30,12 +34,44 @@ namespace platform {
 	 *
 	 * This function captures a single character input from the user without requiring the
 	 * Enter key to be pressed. It is typically used for interactive command-line applications
-	 * where immediate response to keypresses is required.
+	 * where immediate response to keypresses is required. Bytes are served from a buffered
+	 * input queue; when no TerminalSession is active, raw mode is entered just for this call.
 	 *
-	 * @return The ASCII value of the character read from the terminal.
+	 * @return The ASCII value of the character read from the terminal, or EOF at end of input.
 	 */
 	int getch();
 
+	/**
+	 * @brief Returns the next input byte without consuming it, if one is available right now.
+	 *
+	 * Never blocks. The line editor uses it to drain a burst of pasted input in one go
+	 * instead of redrawing after every byte.
+	 *
+	 * @return The next byte getch() would return, or EOF if no input is pending.
+	 */
+	int peekch();
+
+	/**
+	 * @brief Keeps the terminal in raw mode for as long as the object lives.
+	 *
+	 * Interactive readers create one session around a whole prompt instead of switching
+	 * terminal modes around every key read. The previous terminal settings are restored
+	 * when the session ends, at process exit, and when a fatal or stop signal arrives
+	 * (raw mode is re-entered if the process is continued). Bracketed paste is enabled
+	 * while the session is active, so pastes arrive wrapped in ESC[200~ ... ESC[201~.
+	 * Nested sessions are no-ops.
+	 */
+	class TerminalSession {
+	public:
+		TerminalSession();
+		~TerminalSession();
+		TerminalSession(const TerminalSession&) = delete;
+		TerminalSession& operator=(const TerminalSession&) = delete;
+
+	private:
+		bool owner = false;
+	};
+
 	/**
 	 * @brief Sets the terminal window title.
 	 *
@@ -46,6 +82,218 @@ namespace platform {
 	 */
 	void setTerminalTitle(const std::string& title);
 
+	/**
+	 * @brief Writes a block of bytes straight to the terminal.
+	 *
+	 * Bypasses the iostream layers so a whole rendered frame leaves in a single write.
+	 * Callers that also print through std::cout must flush it first.
+	 *
+	 * @param data The bytes to write.
+	 */
+	void writeOutput(const std::string& data);
+
+	/**
+	 * @brief Returns the width of the terminal in columns.
+	 *
+	 * Used by the line editor to work out where a long input line wraps.
+	 * Falls back to 80 columns when the output is not a terminal.
+	 *
+	 * @return The number of columns in the terminal window.
+	 */
+	int terminalWidth();
+
+	/**
+	 * @brief Tells whether stdout (or stderr) is attached to a terminal.
+	 *
+	 * Output that goes to a pipe or a file is written without ANSI colors.
+	 *
+	 * @param errors Check stderr instead of stdout.
+	 * @return True if the stream is a terminal.
+	 */
+	bool isTerminal(bool errors = false);
+
+	/**
+	 * @brief Read-only view of a whole file, memory-mapped where the platform allows.
+	 *
+	 * The view covers the file as it was when it was opened; bytes appended later by
+	 * this or another process are not visible. A missing or empty file gives an empty view.
+	 * Files are only ever replaced (never truncated in place) by replaceFile(), so a live
+	 * mapping stays valid while other instances rewrite the path.
+	 */
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		std::string_view view() const { return {bytes, length}; }
+
+	private:
+		const char* bytes = nullptr;
+		std::size_t length = 0;
+		std::string owned;
+	};
+
+	/**
+	 * @brief Appends a block of bytes to a file in one locked write.
+	 *
+	 * The file is created if needed and opened in append mode; an exclusive advisory
+	 * lock is held for the write, so blocks from concurrent processes never interleave.
+	 *
+	 * @param path The file to append to.
+	 * @param data The bytes to append.
+	 * @param offset If given, receives the file offset the block was written at.
+	 * @return True if every byte was written.
+	 */
+	bool appendFile(const std::string& path, std::string_view data, std::uint64_t* offset = nullptr);
+
+	/**
+	 * @brief Writes a header into a file that is missing or empty, under the same lock as appendFile().
+	 *
+	 * A file that already has content is left alone, so when several processes
+	 * start the same file at once exactly one header lands in it.
+	 *
+	 * @param path The file to start.
+	 * @param header The bytes that open the file.
+	 * @return True if the file now has content (ours or another process's).
+	 */
+	bool startFile(const std::string& path, std::string_view header);
+
+	/**
+	 * @brief Atomically replaces a file's contents.
+	 *
+	 * Writes to a temporary file next to `path` and renames it over the original,
+	 * so readers (and existing mappings) see either the old or the new file, never a mix.
+	 *
+	 * @param path The file to replace.
+	 * @param data The new contents.
+	 * @return True on success.
+	 */
+	bool replaceFile(const std::string& path, std::string_view data);
+
+	/**
+	 * @brief While alive, Ctrl-C (SIGINT) is recorded instead of ending the process.
+	 *
+	 * The CLI holds one around each foreground command so Ctrl-C can cancel the
+	 * command's work; poll takeInterrupt() to see whether it was pressed. System
+	 * calls interrupted by the signal are restarted. Scopes do not nest.
+	 * With `terminate` set, SIGTERM is recorded the same way (used by the daemon).
+	 */
+	class InterruptScope {
+	public:
+		explicit InterruptScope(bool terminate = false);
+		~InterruptScope();
+		InterruptScope(const InterruptScope&) = delete;
+		InterruptScope& operator=(const InterruptScope&) = delete;
+
+	private:
+		bool terminate;
+	};
+
+	/**
+	 * @brief Reports and clears a Ctrl-C recorded by an InterruptScope.
+	 *
+	 * @return True if SIGINT arrived since the last call.
+	 */
+	bool takeInterrupt();
+
+	/**
+	 * @brief Runs a shell command and returns everything it wrote to stdout.
+	 *
+	 * The command runs through /bin/sh in a process group of its own, so terminal
+	 * signals aimed at tcli do not reach it and terminateProcess() can stop it
+	 * together with its children. `started` receives the process id as soon as
+	 * the command is running.
+	 *
+	 * @param command The shell command line.
+	 * @param started Optional callback with the child's process id.
+	 * @return The command's standard output (empty if it could not be started).
+	 */
+	std::string runCommand(const std::string& command, const std::function<void(int pid)>& started = {});
+
+	/**
+	 * @brief Terminates a process started by runCommand() and its process group.
+	 *
+	 * @param pid The id passed to runCommand()'s `started` callback.
+	 */
+	void terminateProcess(int pid);
+
+	/**
+	 * @brief Resolves a host name to one numeric address.
+	 *
+	 * IPv4 addresses are preferred; an IPv6 address comes back in brackets so it
+	 * can be used directly in a `host:port:address` curl --resolve entry.
+	 *
+	 * @param host The host name (or a numeric address, returned as is).
+	 * @return The address, or an empty string if the name does not resolve.
+	 */
+	std::string resolveHost(const std::string& host);
+
+	/**
+	 * @brief Lowers the scheduling priority of the calling thread.
+	 *
+	 * Threads it starts afterwards inherit the lower priority. Background jobs call it
+	 * so their work yields the CPU to the prompt and to foreground commands.
+	 */
+	void lowerThreadPriority();
+
+	/**
+	 * @brief Listens on a UNIX domain socket at `path`.
+	 *
+	 * A socket file left behind by a process that is gone is replaced; one that
+	 * still accepts connections is left alone and the call fails.
+	 *
+	 * @param path File system path of the socket.
+	 * @return The listening descriptor, or -1 on failure.
+	 */
+	int listenLocal(const std::string& path);
+
+	/**
+	 * @brief Waits up to `timeoutMs` for a client on a socket from listenLocal().
+	 *
+	 * @return The connected descriptor, or -1 if none arrived in time.
+	 */
+	int acceptLocal(int listener, int timeoutMs);
+
+	/**
+	 * @brief Connects to the UNIX domain socket at `path`.
+	 *
+	 * @return The connected descriptor, or -1 if nothing listens there.
+	 */
+	int connectLocal(const std::string& path);
+
+	/**
+	 * @brief Writes all of `data` to a socket; a closed peer is reported, not signalled.
+	 *
+	 * @return True if every byte was sent.
+	 */
+	bool sendAll(int fd, std::string_view data);
+
+	/**
+	 * @brief Reads whatever is available on a socket, waiting up to `timeoutMs`.
+	 *
+	 * @param timeoutMs Milliseconds to wait; negative waits indefinitely.
+	 * @return Bytes read, 0 if the peer closed the connection, -1 if nothing arrived in time.
+	 */
+	long receive(int fd, char* buffer, std::size_t size, int timeoutMs);
+
+	/**
+	 * @brief Shuts down the receiving and/or sending side of a socket; the descriptor stays open.
+	 *
+	 * Calls blocked on a side that is shut down return at once: receive() reports
+	 * the peer gone and sendAll() fails.
+	 */
+	void shutdownSocket(int fd, bool receiving, bool sending);
+
+	/**
+	 * @brief Closes a socket descriptor.
+	 */
+	void closeSocket(int fd);
+
 } // namespace platform
 
 #endif
\ No newline at end of file